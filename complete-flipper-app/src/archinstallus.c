@@ -13,6 +13,7 @@
 #include <lib/toolbox/path.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -22,6 +23,24 @@
 #define TAG "ArchInstallus"
 #define APP_VERSION "2.0.0-COMPLETE"
 
+// Build variants, selected by the cdefines of each App() in application.fam
+#if defined(ARCHINSTALLUS_VARIANT_MINIMAL)
+#define ARCHINSTALLUS_VARIANT "minimal"
+#define ARCHINSTALLUS_WITH_FLEET 0
+#define ARCHINSTALLUS_WITH_BACKUP 0
+#define ARCHINSTALLUS_WITH_EDITOR 0
+#elif defined(ARCHINSTALLUS_VARIANT_FLEET)
+#define ARCHINSTALLUS_VARIANT "fleet"
+#define ARCHINSTALLUS_WITH_FLEET 1
+#define ARCHINSTALLUS_WITH_BACKUP 1
+#define ARCHINSTALLUS_WITH_EDITOR 0
+#else
+#define ARCHINSTALLUS_VARIANT "full"
+#define ARCHINSTALLUS_WITH_FLEET 1
+#define ARCHINSTALLUS_WITH_BACKUP 1
+#define ARCHINSTALLUS_WITH_EDITOR 1
+#endif
+
 // Maximum sizes
 #define MAX_MIRRORS 10
 #define MAX_PACKAGES 500
@@ -31,6 +50,77 @@
 #define MAX_PASSWORD 128
 #define MAX_LOG_SIZE 8192
 #define MAX_PROGRESS_STEPS 100
+#define MAX_TRACE_SPANS 256
+#define MAX_TRACE_DEPTH 8
+#define MAX_ARRAY_MEMBERS 8
+#define MAX_STEP_COMMANDS 40
+#define MAX_COMMAND_LEN 224
+#define LUKS_PBKDF_MIN_KIB (64 * 1024)
+#define LUKS_PBKDF_MAX_KIB (1024 * 1024)
+#define INSTALLER_STACK_SIZE (4 * 1024)
+#define PREFETCH_STACK_SIZE (4 * 1024) // host harness measures ~3.1K with 64-bit frames
+#define PREFETCH_STACK_MARGIN 256 // below this much free stack at the deepest point, warn
+#define PREFETCH_MIN_BUDGET_KIB (128 * 1024)
+#define PREFETCH_MAX_BUDGET_KIB (1024 * 1024)
+#define MAX_PREFETCH_SPANS 24
+#define MAX_EXISTING_PARTITIONS 16
+#define EDITOR_VISIBLE_ROWS 5
+#define EDITOR_ROW_HEIGHT 10
+#define EDITOR_PREFIX_LEN 16
+#define EDITOR_MAX_FIELDS 32
+#define EDITOR_ACCEL_REPEATS 6 // repeats at each step size before accelerating
+#define PACKAGE_CATALOG_MAX 256
+#define BACKUP_ZSTD_MIBS 250 // zstd -3 compression per thread
+#define BACKUP_ZSTD_RATIO_PCT 50
+#define BACKUP_TARGET_MIBS 400 // external SSD / 10GbE NFS write speed
+#define WIPE_NVME_FORMAT_MS 2000 // crypto erase only replaces the media key
+#define WIPE_DISCARD_GIBS 200 // whole-device TRIM / deallocate
+#define WIPE_SIGNATURES_MS 500
+#define WIPE_ZERO_BLOCK (4ULL << 20)
+#define SNAPSHOT_BTRFS_TOP "/run/archinstallus/btrfs" // top-level subvolume, holds @ and its snapshots
+#define SNAPSHOT_MAX_RETRIES 2
+#define CHROOT_FIFO_DIR "/run/archinstallus/chroot"
+#define CHROOT_SETUP_MS 350 // arch-chroot mounts, unshare and chroot, plus the umount -R on exit
+#define CHROOT_REPLY_LEN 48
+#define CPU_REPO_SERVER "https://mirror.cachyos.org/repo/$arch/$repo"
+#define CPU_REPO_KEY "F3B607488DB35A47"
+#define CPU_TUNED_KERNEL "linux-cachyos"
+#define BUILD_JOB_MIB 512 // peak RSS of one compiler job
+#define BUILD_RESERVE_MIB 2048 // desktop, editor and page cache during a build
+#define BUILD_TMPFS_MIN_GIB 8 // unpacked kernel tree plus objects
+#define BUILD_CCACHE_MIN_GIB 5
+#define BUILD_CCACHE_MAX_GIB 50
+#define BUILD_BENCH_PATH "/usr/local/bin/makepkg-bench"
+#define VERIFY_DIR "/tmp/archinstallus-verify"
+#define VERIFY_MTREE_AWK VERIFY_DIR "/mtree.awk"
+#define VERIFY_LOG "/var/log/archinstallus-verify.log"
+#define VERIFY_MAX_WORKERS 16
+#define VERIFY_SHA256_MIBS 600 // per core, without SHA extensions
+#define VERIFY_QKK_FILE_US 300 // pacman -Qkk per-file overhead (mtree lookup, stat, open)
+#define VERIFY_HDD_LOCALITY_GAIN 4 // fewer seeks when files are read in inode order
+#define FLEET_MAX_TARGETS 20
+#define FLEET_MAX_WORKERS 8
+#define FLEET_TARGET_NAME 32
+#define FLEET_TARGET_DISKS 64 // space-separated /dev paths of one target
+#define FLEET_TARGET_NAME_CHARS "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789._-"
+#define FLEET_CACHE_DIR "/var/cache/archinstallus/pkg"
+#define FLEET_MIRRORLIST "/var/cache/archinstallus/mirrorlist"
+#define FLEET_HEAP_RESERVE (16 * 1024) // kept free for the GUI and storage after workers are allocated
+
+// SD card locations
+#define APP_DATA_DIR EXT_PATH("apps_data/archinstallus")
+#define TRACE_DIR APP_DATA_DIR "/traces"
+#define CONFIG_PATH APP_DATA_DIR "/archinstallus.ini"
+#define CONFIG_CLASS_DIR APP_DATA_DIR "/classes"
+#define CONFIG_CACHE_PATH APP_DATA_DIR "/config_" ARCHINSTALLUS_VARIANT ".bin" // per variant, they validate differently
+
+// Config loader limits
+#define CONFIG_MAX_FILES 4
+#define CONFIG_PATH_LEN 64
+#define CONFIG_LINE_LEN 192
+#define CONFIG_MAX_FIELDS 48
+#define CONFIG_CACHE_MAGIC 0x46434941 // "AICF"
+#define CONFIG_CACHE_VERSION 9
 
 // Installation types
 typedef enum {
@@ -63,6 +153,13 @@ typedef enum {
     STATE_ERROR = 17
 } InstallState;
 
+// CPU vendor, from the /proc/cpuinfo vendor_id
+typedef enum {
+    CpuVendorUnknown = 0,
+    CpuVendorIntel = 1,
+    CpuVendorAmd = 2
+} CpuVendor;
+
 // Real hardware detection
 typedef struct {
     char cpu_model[128];
@@ -79,6 +176,10 @@ typedef struct {
     bool ethernet_support;
     char network_interfaces[256];
     bool bluetooth_support;
+    bool aes_ni;
+    CpuVendor cpu_vendor;
+    uint8_t cpu_level; // x86-64 microarchitecture level, 1-4
+    bool hypervisor; // running as a guest
 } HardwareInfo;
 
 // Real disk information
@@ -91,8 +192,144 @@ typedef struct {
     char filesystem[64];
     bool mounted;
     char mount_point[128];
+    uint32_t logical_block_size;
+    uint32_t physical_block_size;
+    uint32_t optimal_io_size; // 0 if the device does not report one
+    bool discard; // queue/discard_max_bytes > 0
+    bool secure_discard;
+    bool write_zeroes; // zeroing offloaded to the device (queue/write_zeroes_max_bytes > 0)
+    uint8_t nvme_ses; // best nvme format Secure Erase Setting scoped to this namespace: 0 none, 1 user data, 2 crypto
 } DiskInfo;
 
+// Partition found on a disk before it is wiped, for the pre-wipe backup
+typedef struct {
+    char device[72];
+    char fstype[16];
+    uint64_t size;
+    uint64_t used; // allocated bytes as reported by the filesystem
+} ExistingPartition;
+
+// Multi-disk layouts for root/home
+typedef enum {
+    DiskLayoutSingle = 0,
+    DiskLayoutRaid0 = 1,
+    DiskLayoutRaid1 = 2,
+    DiskLayoutLvmStripe = 3
+} DiskLayout;
+
+// Copy-on-write snapshot mechanism for rollback, derived from the disk plan
+typedef enum {
+    SnapshotBackendNone = 0,
+    SnapshotBackendBtrfs = 1, // root is subvolume @
+    SnapshotBackendLvmThin = 2 // root is a thin volume in arch/pool
+} SnapshotBackend;
+
+// Boot paths; systemd-boot and efistub both boot a unified kernel image
+typedef enum {
+    BootloaderAuto = 0,
+    BootloaderSystemdBoot = 1,
+    BootloaderEfistub = 2,
+    BootloaderGrub = 3
+} Bootloader;
+
+// Data-hygiene policy for the disks being replaced
+typedef enum {
+    WipePolicyFast = 0, // old data must not be seen as filesystems again
+    WipePolicySecure = 1 // old data must not be readable at all
+} WipePolicy;
+
+// Wipe methods, fastest first within each policy
+typedef enum {
+    WipeMethodNvmeFormat = 0,
+    WipeMethodSecureDiscard,
+    WipeMethodWriteZeroes,
+    WipeMethodDiscard,
+    WipeMethodSignatures,
+    WipeMethodZeroFill
+} WipeMethod;
+
+// Resolved storage plan - partition, format, mount and fstab stages all follow it
+typedef struct {
+    DiskLayout layout;
+    uint32_t member_count;
+    uint8_t members[MAX_ARRAY_MEMBERS]; // indices into disks[], members[0] holds the ESP
+    uint32_t stripe_kib;
+    uint32_t data_disks; // disks carrying distinct data, for filesystem stripe hints
+    Bootloader bootloader; // resolved against the firmware before anything is written
+    uint32_t bios_boot_part; // GPT partition numbers, the same on every member; 0 if absent
+    uint32_t swap_part;
+    uint32_t data_part; // root (single) or the array member
+    char swap_device[72]; // raid1: md mirror over every member's swap partition; empty otherwise
+    char efi_partition[72];
+    char root_device[72];
+    char home_device[72];
+    bool encrypted;
+    char root_luks_device[72]; // devices under the dm-crypt mappings when encrypted
+    char home_luks_device[72];
+    SnapshotBackend snapshot_backend;
+} DiskPlan;
+
+// Optimized repositories built for one x86-64 level
+typedef struct {
+    uint8_t level;
+    const char* arch; // pacman.conf Architecture line
+    const char* repos[3];
+    const char* mirrorlist; // package and /etc/pacman.d file
+} CpuRepoSet;
+
+// CPU-specific repositories and packages, resolved from HardwareInfo and the config
+typedef struct {
+    const CpuRepoSet* repos; // NULL keeps the generic x86-64 repositories
+    const char* microcode; // NULL in a guest or for an unknown vendor
+    const char* kernel;
+} CpuPlan;
+
+// LUKS2 cipher candidate
+typedef struct {
+    const char* name;
+    uint16_t key_bits;
+    bool needs_aes_ni;
+} LuksCipher;
+
+// Benchmark result and derived dm-crypt parameters
+typedef struct {
+    const LuksCipher* cipher;
+    uint32_t enc_mibs;
+    uint32_t dec_mibs;
+    uint32_t pbkdf_memory_kib;
+    uint32_t pbkdf_iterations;
+    uint32_t pbkdf_parallel;
+    bool perf_flags;
+} LuksSetup;
+
+// initramfs compressor candidate
+typedef struct {
+    const char* name; // mkinitcpio COMPRESSION value
+    const char* options;
+    uint8_t ratio_pct;
+} InitramfsCompressor;
+
+// Generated mkinitcpio.conf and its boot cost
+typedef struct {
+    char hooks[128];
+    char modules[96];
+    const InitramfsCompressor* compressor;
+    uint32_t cpio_kib;
+    uint32_t size_kib;
+    uint32_t unpack_ms; // ESP read + decompression, estimated
+} InitramfsPlan;
+
+// Commands for one step: text is built at runtime, label is static for tracing. A command can
+// carry a secret (secret_len > 0) that is masked wherever the command is shown
+typedef struct {
+    const char* labels[MAX_STEP_COMMANDS];
+    char text[MAX_STEP_COMMANDS][MAX_COMMAND_LEN];
+    uint8_t secret_at[MAX_STEP_COMMANDS];
+    uint8_t secret_len[MAX_STEP_COMMANDS];
+    uint32_t count;
+    const char* dropped; // label of the first command that did not fit; the list must not run
+} CommandList;
+
 // Real configuration
 typedef struct {
     char hostname[MAX_HOSTNAME];
@@ -102,16 +339,25 @@ typedef struct {
     char timezone[64];
     char keyboard_layout[32];
     char kernel_version[64];
+    char optimized_repos[16]; // auto, off, or a level name to cap at
+    bool tuned_kernel;
     bool enable_uefi;
     bool enable_secure_boot;
+    char bootloader[16];
+    char wipe_policy[16];
     char root_password[MAX_PASSWORD];
     bool create_swap;
     uint64_t swap_size;
     char root_filesystem[32];
     char home_filesystem[32];
+    char disk_layout[16];
     bool enable_encryption;
     char encryption_passphrase[MAX_PASSWORD];
+    char backup_target[64]; // mounted path for the pre-wipe backup, empty to skip it
+    bool backup_restore; // restore backup_target instead of installing
     InstallType install_type;
+    char inject_failure[16]; // post-install stage key to fail, for rollback testing
+    uint32_t inject_failure_count;
     char custom_packages[MAX_PACKAGES][64];
     uint32_t package_count;
     char mirrors[MAX_MIRRORS][128];
@@ -126,8 +372,197 @@ typedef struct {
     bool enable_automated_backups;
     bool enable_performance_tuning;
     bool enable_security_hardening;
+    char fleet_targets[FLEET_MAX_TARGETS][FLEET_TARGET_NAME];
+    char fleet_target_disks[FLEET_MAX_TARGETS][FLEET_TARGET_DISKS];
+    uint32_t fleet_target_count;
+    uint32_t fleet_workers;
+    uint32_t fleet_net_slots;
+    uint32_t fleet_io_slots;
 } InstallConfig;
 
+// Config file sections
+typedef enum {
+    ConfigSectionNone = 0,
+    ConfigSectionSystem,
+    ConfigSectionDisk,
+    ConfigSectionInstall,
+    ConfigSectionFeatures,
+    ConfigSectionPackages,
+    ConfigSectionMirrors,
+    ConfigSectionFleet,
+    ConfigSectionTargets
+} ConfigSection;
+
+typedef enum {
+    ConfigFieldString,
+    ConfigFieldBool,
+    ConfigFieldSize,
+    ConfigFieldUint,
+    ConfigFieldInstallType
+} ConfigFieldType;
+
+// Flash-resident key table: maps "section.key" straight onto InstallConfig
+typedef struct {
+    ConfigSection section;
+    const char* key;
+    ConfigFieldType type;
+    uint16_t offset;
+    uint16_t size;
+} ConfigField;
+
+// One parsed file, fingerprinted so the binary cache can be validated without parsing
+typedef struct {
+    char path[CONFIG_PATH_LEN];
+    uint32_t size;
+    uint32_t timestamp;
+} ConfigSource;
+
+// Where a key was last set, so validation errors can name its line; line 0 means never set
+typedef struct {
+    uint8_t source;
+    uint16_t line;
+} ConfigOrigin;
+
+typedef struct {
+    InstallConfig* config;
+    ConfigSection section;
+    ConfigSource sources[CONFIG_MAX_FILES];
+    uint32_t source_count;
+    uint32_t source; // index of the file being parsed
+    ConfigOrigin origins[CONFIG_MAX_FIELDS]; // per config_fields entry
+    ConfigOrigin targets_origin;
+    uint32_t bytes;
+    uint32_t error_line;
+    char error_file[CONFIG_PATH_LEN];
+    char error[64];
+} ConfigParser;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t config_size;
+    uint32_t source_count;
+    ConfigSource sources[CONFIG_MAX_FILES];
+    uint32_t checksum;
+} ConfigCacheHeader;
+
+// Heap and stack sample for the debug overlay and state-transition log
+typedef struct {
+    size_t free_heap;
+    size_t min_free_heap;
+    size_t max_free_block;
+    uint32_t gui_stack; // unused stack bytes since thread start, 0 if unknown
+    uint32_t installer_stack;
+} MemoryStats;
+
+#if ARCHINSTALLUS_WITH_EDITOR
+// On-device config and package editor; rows index flash tables, nothing is allocated per frame
+typedef enum {
+    EditorTabConfig = 0,
+    EditorTabPackages,
+    EditorTabCount
+} EditorTab;
+
+typedef struct {
+    bool open;
+    EditorTab tab;
+    uint16_t selected[EditorTabCount];
+    uint16_t top[EditorTabCount]; // first visible row
+    uint16_t repeat_count; // consecutive repeats of the held key
+    bool searching;
+    char prefix[EDITOR_PREFIX_LEN];
+    uint8_t prefix_len;
+    uint8_t bool_fields[EDITOR_MAX_FIELDS]; // config_fields indices of the Bool rows
+    uint8_t bool_count;
+    uint8_t catalog_marked[PACKAGE_CATALOG_MAX / 8]; // package_catalog entries present in custom_packages
+    char error[40]; // why the last toggle was undone, shown in the header until the next key
+    uint32_t frame_us;
+    uint32_t frame_us_max;
+} ConfigEditor;
+#endif
+
+// Persistent arch-chroot for the configuration stages; a bash inside the target reads framed
+// commands from one FIFO and answers each with its exit status and timing on another
+typedef struct {
+    bool active;
+    uint32_t open_tick;
+    uint32_t setup_us; // arch-chroot start until the session took its first command
+    uint32_t commands;
+    uint32_t failed;
+    uint64_t busy_us; // sum of the per-command times reported back
+} ChrootSession;
+
+// Span tracing - one entry per step / sub-step
+typedef struct {
+    const char* name;
+    uint8_t depth;
+    uint8_t tid; // 1 = pipeline, 2 = prefetch
+    uint32_t begin_tick;
+    uint32_t end_tick;
+    uint32_t wait_ticks;
+    size_t heap_begin;
+    size_t heap_end;
+} TraceSpan;
+
+typedef struct {
+    TraceSpan spans[MAX_TRACE_SPANS];
+    uint32_t span_count;
+    uint32_t dropped;
+    uint16_t open[MAX_TRACE_DEPTH];
+    uint8_t depth;
+} TraceBuffer;
+
+// Package prefetch running alongside the disk stages; bitmaps index base_packages
+typedef struct {
+    FuriThread* thread;
+    FuriMutex* mutex;
+    uint32_t fetching; // being fetched by the prefetch thread
+    uint32_t staged; // in staging, not yet handed over
+    uint32_t claimed; // taken over by the download stage, prefetch skips these
+    uint32_t staged_kib;
+    uint32_t budget_kib;
+    uint32_t peak_kib;
+    uint32_t prefetched;
+    uint32_t handed_over;
+    uint32_t stall_ticks;
+    uint32_t stack_free; // least free stack of the worker in bytes, 0 if unknown
+    bool stop;
+    TraceSpan spans[MAX_PREFETCH_SPANS]; // merged into the pipeline trace on stop
+    uint32_t span_count;
+} PackagePrefetch;
+
+// Fleet mode - per-target status, aggregated by the orchestrator
+typedef enum {
+    FleetTargetQueued = 0,
+    FleetTargetRunning,
+    FleetTargetDone,
+    FleetTargetFailed
+} FleetTargetStatus;
+
+typedef struct {
+    FleetTargetStatus status;
+    uint8_t worker;
+    InstallState state;
+    uint32_t start_tick;
+    uint32_t end_tick;
+    char error[48];
+} FleetTarget;
+
+// Shared by all pipelines of one fleet run
+typedef struct {
+    FuriMutex* mutex;
+    FuriSemaphore* net_budget;
+    FuriSemaphore* io_budget;
+    FleetTarget targets[FLEET_MAX_TARGETS];
+    uint32_t target_count;
+    uint32_t next_target;
+    bool mirrors_ranked;
+    uint32_t cached_packages; // bitmap over base_packages already in the shared cache
+    uint32_t fetching_packages; // bitmap over base_packages another pipeline is downloading
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+} ArchInstallusFleet;
+
 // Real application state
 typedef struct {
     Gui* gui;
@@ -142,7 +577,9 @@ typedef struct {
     HardwareInfo hw_info;
     DiskInfo disks[MAX_DISKS];
     uint32_t disk_count;
-    InstallConfig config;
+    ExistingPartition existing[MAX_EXISTING_PARTITIONS];
+    uint32_t existing_count;
+    InstallConfig* config;
     NotificationApp* notifications;
     Storage* storage;
     FuriString* log_buffer;
@@ -150,262 +587,2703 @@ typedef struct {
     uint32_t start_time;
     bool rollback_enabled;
     bool backup_created;
+    TraceBuffer trace;
+    DiskPlan disk_plan;
+    CpuPlan cpu_plan;
+    LuksSetup luks;
+    InitramfsPlan initramfs;
+    CommandList commands;
+    ChrootSession chroot;
+    bool config_valid; // false while the SD config fails to load; Start is refused
+    ArchInstallusFleet* fleet; // NULL outside fleet mode
+    PackagePrefetch* prefetch; // NULL unless a prefetch is running
+    const char* target_name;
+    const char* target_disks; // fleet target's own disks, NULL outside fleet mode
+    FuriThread* installer_thread;
+    uint32_t installer_stack_free; // written by the installer thread only, read by the overlay
+    FuriThreadId gui_thread_id; // captured by the draw callback
+    bool debug_overlay;
+#if ARCHINSTALLUS_WITH_EDITOR
+    ConfigEditor editor;
+#endif
+    const char* snapshot_key; // last good snapshot, NULL before the first one
+    const char* stage_key; // post-install stage being run, NULL outside them
+    uint32_t injected_failures;
 } ArchInstallusComplete;
 
-// Real system functions
-static bool archinstallus_detect_hardware(ArchInstallusComplete* app) {
-    app->state = STATE_HARDWARE_DETECT;
-    snprintf(app->status_message, sizeof(app->status_message), "Detecting hardware...");
-    app->step_progress = 0;
-    
-    // Real CPU detection
-    furi_delay_ms(1000);
-    snprintf(app->hw_info.cpu_model, sizeof(app->hw_info.cpu_model), "Intel Core i7-11700K");
-    app->hw_info.cpu_cores = 8;
-    app->hw_info.cpu_threads = 16;
-    app->step_progress = 20;
-    
-    // Real memory detection
-    furi_delay_ms(500);
-    app->hw_info.memory_total = 16777216000ULL; // 16GB
-    app->hw_info.memory_available = 8589934592ULL; // 8GB available
-    app->step_progress = 40;
-    
-    // Real disk detection
-    furi_delay_ms(1000);
-    snprintf(app->hw_info.disk_model, sizeof(app->hw_info.disk_model), "Samsung SSD 980 PRO 1TB");
-    app->hw_info.disk_size = 1000204886016ULL; // 1TB
-    app->hw_info.ssd_support = true;
-    app->step_progress = 60;
-    
-    // Real UEFI detection
-    furi_delay_ms(500);
-    app->hw_info.uefi_support = true;
-    app->hw_info.secure_boot = false;
-    app->step_progress = 80;
-    
-    // Real network detection
-    furi_delay_ms(500);
-    app->hw_info.ethernet_support = true;
-    app->hw_info.wireless_support = true;
-    snprintf(app->hw_info.network_interfaces, sizeof(app->hw_info.network_interfaces), "eth0, wlan0");
-    app->step_progress = 100;
-    
-    return true;
+// Span tracing
+static void archinstallus_trace_reset(ArchInstallusComplete* app) {
+    app->trace.span_count = 0;
+    app->trace.dropped = 0;
+    app->trace.depth = 0;
 }
 
-static bool archinstallus_detect_disks(ArchInstallusComplete* app) {
-    app->state = STATE_DISK_DETECT;
-    snprintf(app->status_message, sizeof(app->status_message), "Scanning disk drives...");
-    app->step_progress = 0;
-    
-    // Real disk scanning
-    app->disk_count = 0;
-    
-    // Primary disk
-    snprintf(app->disks[0].device_path, sizeof(app->disks[0].device_path), "/dev/nvme0n1");
-    snprintf(app->disks[0].model, sizeof(app->disks[0].model), "Samsung SSD 980 PRO");
-    app->disks[0].size = 1000204886016ULL;
-    app->disks[0].is_ssd = true;
-    app->disks[0].partitions = 0;
-    app->disks[0].mounted = false;
-    app->disk_count++;
-    app->step_progress = 50;
-    
-    furi_delay_ms(1000);
-    app->step_progress = 100;
-    
-    return app->disk_count > 0;
+static void archinstallus_trace_begin(ArchInstallusComplete* app, const char* name) {
+    TraceBuffer* trace = &app->trace;
+    if(trace->span_count >= MAX_TRACE_SPANS || trace->depth >= MAX_TRACE_DEPTH) {
+        // Still track nesting so the matching end pops correctly
+        if(trace->depth < MAX_TRACE_DEPTH) trace->open[trace->depth] = UINT16_MAX;
+        trace->depth++;
+        trace->dropped++;
+        return;
+    }
+
+    TraceSpan* span = &trace->spans[trace->span_count];
+    span->name = name;
+    span->depth = trace->depth;
+    span->tid = 1;
+    span->begin_tick = furi_get_tick();
+    span->end_tick = span->begin_tick;
+    span->wait_ticks = 0;
+    span->heap_begin = memmgr_get_free_heap();
+    span->heap_end = span->heap_begin;
+
+    trace->open[trace->depth++] = trace->span_count++;
 }
 
-static bool archinstallus_detect_network(ArchInstallusComplete* app) {
-    app->state = STATE_NETWORK_DETECT;
-    snprintf(app->status_message, sizeof(app->status_message), "Testing network connectivity...");
-    app->step_progress = 0;
-    
-    // Real network test
-    furi_delay_ms(2000);
-    app->step_progress = 50;
-    
-    furi_delay_ms(1000);
-    app->step_progress = 100;
-    
-    return true;
+static void archinstallus_trace_end(ArchInstallusComplete* app) {
+    TraceBuffer* trace = &app->trace;
+    if(trace->depth == 0) return;
+
+    trace->depth--;
+    if(trace->depth >= MAX_TRACE_DEPTH || trace->open[trace->depth] == UINT16_MAX) return;
+
+    TraceSpan* span = &trace->spans[trace->open[trace->depth]];
+    span->end_tick = furi_get_tick();
+    span->heap_end = memmgr_get_free_heap();
 }
 
-static bool archinstallus_partition_disk(ArchInstallusComplete* app) {
-    app->state = STATE_PARTITIONING;
-    snprintf(app->status_message, sizeof(app->status_message), "Creating partitions...");
-    app->step_progress = 0;
-    
-    // Real partitioning for GPT
-    const char* partition_commands[] = {
-        "sgdisk --zap-all /dev/nvme0n1",
-        "sgdisk --new=1:0:+512M /dev/nvme0n1", // EFI System Partition
-        "sgdisk --new=2:0:+4G /dev/nvme0n1",   // Swap partition
-        "sgdisk --new=3:0:+128G /dev/nvme0n1", // Root partition
-        "sgdisk --new=4:0:0 /dev/nvme0n1",     // Home partition
-        "sgdisk --typecode=1:ef00 /dev/nvme0n1",
-        "sgdisk --typecode=2:8200 /dev/nvme0n1",
-        "sgdisk --typecode=3:8300 /dev/nvme0n1",
-        "sgdisk --typecode=4:8300 /dev/nvme0n1"
-    };
-    
-    for(int i = 0; i < 9; i++) {
-        furi_delay_ms(500);
-        app->step_progress = ((i + 1) * 100) / 9;
-        snprintf(app->status_message, sizeof(app->status_message), "Partition %d/8: %s", i + 1, partition_commands[i]);
+// Charge blocked time as wait time to every open span
+static void archinstallus_trace_wait(ArchInstallusComplete* app, uint32_t waited) {
+    TraceBuffer* trace = &app->trace;
+    uint8_t depth = trace->depth < MAX_TRACE_DEPTH ? trace->depth : MAX_TRACE_DEPTH;
+    for(uint8_t i = 0; i < depth; i++) {
+        if(trace->open[i] != UINT16_MAX) trace->spans[trace->open[i]].wait_ticks += waited;
     }
-    
-    app->disks[0].partitions = 4;
-    return true;
 }
 
-static bool archinstallus_format_partitions(ArchInstallusComplete* app) {
-    app->state = STATE_FORMATTING;
-    snprintf(app->status_message, sizeof(app->status_message), "Formatting partitions...");
-    app->step_progress = 0;
-    
-    // Real filesystem creation
-    const char* format_commands[] = {
-        "mkfs.vfat -F32 -n EFI /dev/nvme0n1p1",
-        "mkswap /dev/nvme0n1p2",
-        "mkfs.ext4 -L ROOT /dev/nvme0n1p3",
-        "mkfs.ext4 -L HOME /dev/nvme0n1p4"
-    };
-    
-    for(int i = 0; i < 4; i++) {
-        furi_delay_ms(800);
-        app->step_progress = ((i + 1) * 100) / 4;
-        snprintf(app->status_message, sizeof(app->status_message), "Format %d/4: %s", i + 1, format_commands[i]);
+// Blocking wait on an external operation
+static void archinstallus_wait(ArchInstallusComplete* app, uint32_t ms) {
+    uint32_t start = furi_get_tick();
+    furi_delay_ms(ms);
+    archinstallus_trace_wait(app, furi_get_tick() - start);
+}
+
+// Fleet I/O and network budgets; no-ops for a single target
+static void archinstallus_budget_acquire(ArchInstallusComplete* app, FuriSemaphore* budget) {
+    if(!app->fleet) return;
+    uint32_t start = furi_get_tick();
+    furi_semaphore_acquire(budget, FuriWaitForever);
+    archinstallus_trace_wait(app, furi_get_tick() - start);
+}
+
+static void archinstallus_budget_release(ArchInstallusComplete* app, FuriSemaphore* budget) {
+    if(!app->fleet) return;
+    furi_semaphore_release(budget);
+}
+
+static uint64_t archinstallus_ticks_to_us(uint32_t ticks) {
+    return ((uint64_t)ticks * 1000000ULL) / furi_kernel_get_tick_frequency();
+}
+
+// Export the span buffer as Chrome trace JSON (chrome://tracing, Perfetto)
+static bool archinstallus_trace_export(ArchInstallusComplete* app, bool success) {
+    TraceBuffer* trace = &app->trace;
+    if(trace->span_count == 0) return false;
+
+    storage_simply_mkdir(app->storage, APP_DATA_DIR);
+    storage_simply_mkdir(app->storage, TRACE_DIR);
+
+    char path[128];
+    if(app->target_name) {
+        snprintf(path, sizeof(path), TRACE_DIR "/trace_%lu_%s.json", furi_hal_rtc_get_timestamp(), app->target_name);
+    } else {
+        snprintf(path, sizeof(path), TRACE_DIR "/trace_%lu.json", furi_hal_rtc_get_timestamp());
     }
-    
-    return true;
+
+    File* file = storage_file_alloc(app->storage);
+    if(!storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        FURI_LOG_E(TAG, "Failed to open %s", path);
+        storage_file_free(file);
+        return false;
+    }
+
+    FuriString* line = furi_string_alloc();
+    uint32_t origin = trace->spans[0].begin_tick;
+    bool ok = true;
+
+    furi_string_printf(
+        line,
+        "{\"otherData\":{\"version\":\"%s\",\"hostname\":\"%s\",\"result\":\"%s\",\"dropped\":%lu},\n"
+        "\"traceEvents\":[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"pipeline\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"prefetch\"}},\n",
+        APP_VERSION,
+        app->target_name ? app->target_name : app->config->hostname,
+        success ? "ok" : "error",
+        trace->dropped);
+    ok &= storage_file_write(file, furi_string_get_cstr(line), furi_string_size(line)) ==
+          furi_string_size(line);
+
+    for(uint32_t i = 0; i < trace->span_count && ok; i++) {
+        TraceSpan* span = &trace->spans[i];
+        uint32_t duration = span->end_tick - span->begin_tick;
+        uint32_t work = duration > span->wait_ticks ? duration - span->wait_ticks : 0;
+        furi_string_printf(
+            line,
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%llu,\"dur\":%llu,\"args\":{\"depth\":%u,\"wait_us\":%llu,\"work_us\":%llu,"
+            "\"heap_begin\":%u,\"heap_end\":%u}}%s\n",
+            span->name,
+            span->tid == 2 ? "prefetch" : span->depth == 0 ? "step" : "substep",
+            span->tid,
+            archinstallus_ticks_to_us(span->begin_tick - origin),
+            archinstallus_ticks_to_us(duration),
+            span->depth,
+            archinstallus_ticks_to_us(span->wait_ticks),
+            archinstallus_ticks_to_us(work),
+            span->heap_begin,
+            span->heap_end,
+            i + 1 < trace->span_count ? "," : "");
+        ok &= storage_file_write(file, furi_string_get_cstr(line), furi_string_size(line)) ==
+              furi_string_size(line);
+    }
+
+    const char* footer = "]}\n";
+    ok &= storage_file_write(file, footer, strlen(footer)) == strlen(footer);
+
+    furi_string_free(line);
+    storage_file_close(file);
+    storage_file_free(file);
+
+    FURI_LOG_I(TAG, "Trace: %lu spans (%lu dropped) -> %s", trace->span_count, trace->dropped, path);
+    return ok;
 }
 
-static bool archinstallus_mount_filesystems(ArchInstallusComplete* app) {
-    app->state = STATE_MOUNTING;
-    snprintf(app->status_message, sizeof(app->status_message), "Mounting filesystems...");
-    app->step_progress = 0;
-    
-    // Real mount operations
-    const char* mount_commands[] = {
-        "mount /dev/nvme0n1p3 /mnt",
-        "mkdir -p /mnt/boot/efi",
-        "mount /dev/nvme0n1p1 /mnt/boot/efi",
-        "mkdir -p /mnt/home",
-        "mount /dev/nvme0n1p4 /mnt/home",
-        "swapon /dev/nvme0n1p2"
-    };
-    
-    for(int i = 0; i < 6; i++) {
-        furi_delay_ms(600);
-        app->step_progress = ((i + 1) * 100) / 6;
-        snprintf(app->status_message, sizeof(app->status_message), "Mount %d/6: %s", i + 1, mount_commands[i]);
+// Install log, shared with the main loop
+static void archinstallus_log(ArchInstallusComplete* app, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    furi_mutex_acquire(app->log_mutex, FuriWaitForever);
+    furi_string_cat_printf(app->log_buffer, "[%lu] ", furi_get_tick() - app->start_time);
+    // The orchestrator logs for the whole fleet, pipelines for their target
+    if(app->fleet && app->target_name) furi_string_cat_printf(app->log_buffer, "%s: ", app->target_name);
+    furi_string_cat_vprintf(app->log_buffer, format, args);
+    furi_string_push_back(app->log_buffer, '\n');
+    furi_mutex_release(app->log_mutex);
+    va_end(args);
+}
+
+// Memory helpers; the installer's stack is only measured on its own thread, the GUI sees the last snapshot
+// rather than querying a thread that may already have exited
+static void archinstallus_memory_sample(ArchInstallusComplete* app, MemoryStats* stats) {
+    stats->free_heap = memmgr_get_free_heap();
+    stats->min_free_heap = memmgr_get_minimum_free_heap();
+    stats->max_free_block = memmgr_heap_get_max_free_block();
+    stats->gui_stack = app->gui_thread_id ? furi_thread_get_stack_space(app->gui_thread_id) : 0;
+    stats->installer_stack = app->installer_stack_free;
+}
+
+// Logged on every step entry, from the installer (or fleet worker) thread itself
+static void archinstallus_memory_log(ArchInstallusComplete* app, const char* step) {
+    MemoryStats stats;
+    app->installer_stack_free = furi_thread_get_stack_space(furi_thread_get_current_id());
+    archinstallus_memory_sample(app, &stats);
+    archinstallus_log(
+        app,
+        "Mem: %s heap %u min %u blk %u, stack free gui %lu installer %lu",
+        step,
+        stats.free_heap,
+        stats.min_free_heap,
+        stats.max_free_block,
+        stats.gui_stack,
+        stats.installer_stack);
+}
+
+// Step command lists
+static void archinstallus_cmd_reset(ArchInstallusComplete* app) {
+    app->commands.count = 0;
+    app->commands.dropped = NULL;
+}
+
+static void archinstallus_cmd_add(ArchInstallusComplete* app, const char* label, const char* format, ...) {
+    CommandList* list = &app->commands;
+    if(list->count >= MAX_STEP_COMMANDS) {
+        FURI_LOG_W(TAG, "Command list full, dropping: %s", label);
+        if(!list->dropped) list->dropped = label;
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(list->text[list->count], MAX_COMMAND_LEN, format, args);
+    va_end(args);
+    // A cut-off shell command could do something else entirely, so it is not run
+    if(len >= MAX_COMMAND_LEN) {
+        FURI_LOG_W(TAG, "Command too long (%d chars), dropping: %s", len, label);
+        if(!list->dropped) list->dropped = label;
+        return;
+    }
+    list->secret_len[list->count] = 0;
+    list->labels[list->count++] = label;
+}
+
+// Command fed one "name:secret" line on stdin through a heredoc, so the input travels with the
+// command itself; only the secret is masked when shown
+static void archinstallus_cmd_add_input(
+    ArchInstallusComplete* app, const char* label, const char* command, const char* name, const char* secret) {
+    CommandList* list = &app->commands;
+    uint32_t index = list->count;
+    archinstallus_cmd_add(app, label, "%s <<'EOF'\n%s:%s\nEOF", command, name, secret);
+    if(list->count == index) return;
+    list->secret_at[index] = strlen(command) + strlen(" <<'EOF'\n") + strlen(name) + 1;
+    list->secret_len[index] = strlen(secret);
+}
+
+// Printable form of a queued command for the log and status line: newlines as \n, secret masked
+static const char* archinstallus_cmd_display(const CommandList* list, uint32_t index, char* buf, size_t size) {
+    const char* text = list->text[index];
+    size_t out = 0;
+    for(size_t i = 0; text[i] && out + 9 < size; i++) {
+        if(list->secret_len[index] && i == list->secret_at[index]) {
+            memcpy(buf + out, "********", 8);
+            out += 8;
+            i += list->secret_len[index] - 1;
+        } else if(text[i] == '\n') {
+            buf[out++] = '\\';
+            buf[out++] = 'n';
+        } else {
+            buf[out++] = text[i];
+        }
+    }
+    buf[out] = '\0';
+    return buf;
+}
+
+// A list with a hole in it (a skipped wipe or luksFormat before mkfs) fails the step before anything runs
+static bool archinstallus_cmd_complete(ArchInstallusComplete* app, const char* prefix) {
+    if(!app->commands.dropped) return true;
+    archinstallus_log(app, "%s: \"%s\" did not fit in the command list, step not run", prefix, app->commands.dropped);
+    return false;
+}
+
+// Run the queued commands with per-command progress, trace spans and log lines
+static bool archinstallus_cmd_run(ArchInstallusComplete* app, const char* prefix, uint32_t delay_ms) {
+    CommandList* list = &app->commands;
+    if(!archinstallus_cmd_complete(app, prefix)) return false;
+    for(uint32_t i = 0; i < list->count; i++) {
+        archinstallus_trace_begin(app, list->labels[i]);
+        char shown[MAX_COMMAND_LEN + 16];
+        archinstallus_cmd_display(list, i, shown, sizeof(shown));
+        archinstallus_log(app, "%s: %s", prefix, shown);
+        archinstallus_wait(app, delay_ms);
+        app->step_progress = ((i + 1) * 100) / list->count;
+        snprintf(app->status_message, sizeof(app->status_message), "%s %lu/%lu: %s", prefix, i + 1, list->count, shown);
+        archinstallus_trace_end(app);
     }
-    
-    app->disks[0].mounted = true;
-    snprintf(app->disks[0].mount_point, sizeof(app->disks[0].mount_point), "/mnt");
     return true;
 }
 
-static bool archinstallus_download_base_system(ArchInstallusComplete* app) {
-    app->state = STATE_DOWNLOADING;
-    snprintf(app->status_message, sizeof(app->status_message), "Downloading Arch Linux...");
-    app->step_progress = 0;
+// Config-driven failure injection for exercising rollback on scratch/loop devices
+static bool archinstallus_inject_failure(ArchInstallusComplete* app, const char* key) {
+    if(strcmp(app->config->inject_failure, key) != 0) return false;
+    if(app->injected_failures >= app->config->inject_failure_count) return false;
+    app->injected_failures++;
+    archinstallus_log(app, "Injected failure in %s (%lu/%lu)", key, app->injected_failures, app->config->inject_failure_count);
+    return true;
+}
+
+// Persistent chroot session: opened by the first command that needs the target, closed once
+static void archinstallus_chroot_open(ArchInstallusComplete* app) {
+    ChrootSession* session = &app->chroot;
+    if(session->active) return;
     
-    // Real pacstrap with progress simulation
-    const char* base_packages[] = {
-        "base",
-        "base-devel", 
-        "linux",
-        "linux-firmware",
-        "linux-headers",
-        "networkmanager",
-        "dhcpcd",
-        "wpa_supplicant",
-        "systemd",
-        "systemd-sysvcompat",
-        "grub",
-        "efibootmgr",
-        "sudo",
-        "bash-completion",
-        "curl",
-        "wget",
-        "git",
-        "vim",
-        "nano"
-    };
+    session->open_tick = furi_get_tick();
+    session->commands = 0;
+    session->failed = 0;
+    session->busy_us = 0;
+    archinstallus_trace_begin(app, "Enter target");
+    archinstallus_log(app, "Chroot: mkdir -p " CHROOT_FIFO_DIR " && mkfifo " CHROOT_FIFO_DIR "/in " CHROOT_FIFO_DIR "/out");
+    archinstallus_log(app, "Chroot: arch-chroot /mnt /bin/bash --noprofile --norc < " CHROOT_FIFO_DIR "/in > " CHROOT_FIFO_DIR "/out 2>&1 &");
+    archinstallus_log(app, "Chroot: exec 3> " CHROOT_FIFO_DIR "/in 4< " CHROOT_FIFO_DIR "/out");
+    archinstallus_wait(app, CHROOT_SETUP_MS);
+    archinstallus_trace_end(app);
+    session->setup_us = (uint32_t)archinstallus_ticks_to_us(furi_get_tick() - session->open_tick);
+    session->active = true;
+}
+
+// Leave the target: one teardown for every command the session ran. Safe to call twice.
+static void archinstallus_chroot_close(ArchInstallusComplete* app) {
+    ChrootSession* session = &app->chroot;
+    if(!session->active) return;
     
-    int total_packages = sizeof(base_packages) / sizeof(base_packages[0]);
+    archinstallus_log(app, "Chroot: echo exit >&3 && wait && exec 3>&- 4<&- && rm -rf " CHROOT_FIFO_DIR);
+    session->active = false;
+    uint32_t wall_ms = (uint32_t)(archinstallus_ticks_to_us(furi_get_tick() - session->open_tick) / 1000);
+    archinstallus_log(
+        app,
+        "Chroot: %lu commands (%lu failed) in one session, %lu ms open, %lu ms in commands, %lu ms setup paid once",
+        session->commands,
+        session->failed,
+        wall_ms,
+        (uint32_t)(session->busy_us / 1000),
+        session->setup_us / 1000);
+}
+
+// Reply the target's bash writes to fd 4 for each command: "@@<id> <status> <start> <end>", the
+// times being $EPOCHREALTIME (seconds, six decimals). False for a malformed line or another id.
+static bool archinstallus_chroot_parse_reply(const char* line, uint32_t id, int32_t* status, uint64_t* busy_us) {
+    char* end;
+    if(strncmp(line, "@@", 2) != 0) return false;
+    if(strtoul(line + 2, &end, 10) != id || *end != ' ') return false;
+    *status = strtol(end, &end, 10);
     
-    for(int i = 0; i < total_packages; i++) {
-        furi_delay_ms(200);
-        app->step_progress = ((i + 1) * 100) / total_packages;
-        snprintf(app->status_message, sizeof(app->status_message), "Download %d/%d: %s", i + 1, total_packages, base_packages[i]);
+    uint64_t stamps[2];
+    for(size_t i = 0; i < COUNT_OF(stamps); i++) {
+        if(*end != ' ') return false;
+        uint64_t seconds = strtoull(end + 1, &end, 10);
+        if(*end != '.') return false;
+        const char* fraction = end + 1;
+        uint64_t micros = strtoull(fraction, &end, 10);
+        if(end - fraction != 6) return false;
+        stamps[i] = seconds * 1000000 + micros;
     }
-    
+    if(*end != '\0' || stamps[1] < stamps[0]) return false;
+    *busy_us = stamps[1] - stamps[0];
     return true;
 }
 
-static bool archinstallus_install_system(ArchInstallusComplete* app) {
-    app->state = STATE_INSTALLING;
-    snprintf(app->status_message, sizeof(app->status_message), "Installing system packages...");
-    app->step_progress = 0;
-    
-    // Real installation with progress
-    const char* install_steps[] = {
-        "Installing base system",
-        "Configuring locales",
-        "Setting up timezone",
-        "Configuring hostname",
-        "Creating users",
-        "Setting up services",
-        "Installing bootloader",
-        "Configuring network",
-        "Setting up security",
-        "Installing desktop environment"
-    };
-    
-    int total_steps = sizeof(install_steps) / sizeof(install_steps[0]);
+// Target end of the session as the app models it: the command takes delay_ms and is answered in
+// the bash reply format. Failure injection fails the stage's last command, after everything else
+// in it has run, which is the worst case for the retry
+static void archinstallus_chroot_respond(
+    ArchInstallusComplete* app, uint32_t id, bool last, uint32_t delay_ms, char* reply, size_t size) {
+    uint64_t start = archinstallus_ticks_to_us(furi_get_tick());
+    archinstallus_wait(app, delay_ms);
+    uint64_t end = archinstallus_ticks_to_us(furi_get_tick());
+    int32_t status = last && app->stage_key && archinstallus_inject_failure(app, app->stage_key) ? 1 : 0;
+    snprintf(
+        reply, size, "@@%lu %ld %lu.%06lu %lu.%06lu", id, status,
+        (uint32_t)(start / 1000000), (uint32_t)(start % 1000000), (uint32_t)(end / 1000000), (uint32_t)(end % 1000000));
+}
+
+// Run the queued commands inside the target through the session. Each is written to fd 3 as
+//   s=$EPOCHREALTIME; { <command>
+//   } </dev/null; echo "@@<id> $? $s $EPOCHREALTIME"
+// (stdin from /dev/null so no command can swallow the stream; the newline before the brace ends a
+// heredoc in the command) and its reply line read from fd 4.
+static bool archinstallus_chroot_run(ArchInstallusComplete* app, const char* prefix, uint32_t delay_ms) {
+    ChrootSession* session = &app->chroot;
+    CommandList* list = &app->commands;
+    if(!archinstallus_cmd_complete(app, prefix)) return false;
+    archinstallus_chroot_open(app);
     
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(800);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "Install %d/%d: %s", i + 1, total_steps, install_steps[i]);
+    for(uint32_t i = 0; i < list->count; i++) {
+        uint32_t id = ++session->commands;
+        archinstallus_trace_begin(app, list->labels[i]);
+        char shown[MAX_COMMAND_LEN + 16];
+        archinstallus_cmd_display(list, i, shown, sizeof(shown));
+        archinstallus_log(app, "%s: @@%lu %s", prefix, id, shown);
+        char reply[CHROOT_REPLY_LEN];
+        archinstallus_chroot_respond(app, id, i + 1 == list->count, delay_ms, reply, sizeof(reply));
+        int32_t status;
+        uint64_t busy_us;
+        if(!archinstallus_chroot_parse_reply(reply, id, &status, &busy_us)) {
+            // Out of step with the target, nothing after this can be trusted
+            archinstallus_log(app, "%s: bad reply for @@%lu: %s", prefix, id, reply);
+            status = -1;
+            busy_us = 0;
+        }
+        session->busy_us += busy_us;
+        app->step_progress = ((i + 1) * 100) / list->count;
+        snprintf(app->status_message, sizeof(app->status_message), "%s %lu/%lu: %s", prefix, i + 1, list->count, shown);
+        archinstallus_trace_end(app);
+        if(status != 0) {
+            session->failed++;
+            archinstallus_log(app, "%s: @@%lu exited with %ld", prefix, id, status);
+            return false;
+        }
     }
-    
     return true;
 }
 
-static bool archinstallus_configure_system(ArchInstallusComplete* app) {
-    app->state = STATE_CONFIGURING;
-    snprintf(app->status_message, sizeof(app->status_message), "Configuring system...");
-    app->step_progress = 0;
-    
-    // Real configuration
-    const char* config_steps[] = {
-        "Configuring /etc/fstab",
-        "Setting up locale settings",
-        "Configuring timezone",
-        "Setting hostname",
-        "Configuring network",
-        "Setting up user accounts",
-        "Configuring sudo access",
-        "Setting up firewall",
-        "Configuring services",
-        "Installing additional packages"
-    };
-    
-    int total_steps = sizeof(config_steps) / sizeof(config_steps[0]);
+// SD configuration loader
+#define CONFIG_STR(section, key, field) \
+    {section, key, ConfigFieldString, offsetof(InstallConfig, field), sizeof(((InstallConfig*)0)->field)}
+#define CONFIG_BOOL(section, key, field) \
+    {section, key, ConfigFieldBool, offsetof(InstallConfig, field), sizeof(bool)}
+#define CONFIG_UINT(section, key, field) \
+    {section, key, ConfigFieldUint, offsetof(InstallConfig, field), sizeof(uint32_t)}
+
+static const ConfigField config_fields[] = {
+    CONFIG_STR(ConfigSectionSystem, "hostname", hostname),
+    CONFIG_STR(ConfigSectionSystem, "username", username),
+    CONFIG_STR(ConfigSectionSystem, "password", password),
+    CONFIG_STR(ConfigSectionSystem, "root_password", root_password),
+    CONFIG_STR(ConfigSectionSystem, "locale", locale),
+    CONFIG_STR(ConfigSectionSystem, "timezone", timezone),
+    CONFIG_STR(ConfigSectionSystem, "keyboard_layout", keyboard_layout),
+    CONFIG_STR(ConfigSectionSystem, "kernel", kernel_version),
+    CONFIG_STR(ConfigSectionSystem, "optimized_repos", optimized_repos),
+    CONFIG_BOOL(ConfigSectionSystem, "tuned_kernel", tuned_kernel),
+    CONFIG_STR(ConfigSectionDisk, "root_filesystem", root_filesystem),
+    CONFIG_STR(ConfigSectionDisk, "home_filesystem", home_filesystem),
+    CONFIG_STR(ConfigSectionDisk, "layout", disk_layout),
+    CONFIG_STR(ConfigSectionDisk, "bootloader", bootloader),
+    CONFIG_STR(ConfigSectionDisk, "wipe", wipe_policy),
+    CONFIG_BOOL(ConfigSectionDisk, "create_swap", create_swap),
+    {ConfigSectionDisk, "swap_size", ConfigFieldSize, offsetof(InstallConfig, swap_size), sizeof(uint64_t)},
+    CONFIG_BOOL(ConfigSectionDisk, "uefi", enable_uefi),
+    CONFIG_BOOL(ConfigSectionDisk, "secure_boot", enable_secure_boot),
+    CONFIG_BOOL(ConfigSectionDisk, "encryption", enable_encryption),
+    CONFIG_STR(ConfigSectionDisk, "backup_target", backup_target),
+    CONFIG_BOOL(ConfigSectionDisk, "restore", backup_restore),
+    CONFIG_STR(ConfigSectionDisk, "encryption_passphrase", encryption_passphrase),
+    {ConfigSectionInstall, "type", ConfigFieldInstallType, offsetof(InstallConfig, install_type), sizeof(InstallType)},
+    CONFIG_STR(ConfigSectionInstall, "inject_failure", inject_failure),
+    CONFIG_UINT(ConfigSectionInstall, "inject_failure_count", inject_failure_count),
+    CONFIG_BOOL(ConfigSectionFeatures, "kali_tools", enable_kali_tools),
+    CONFIG_BOOL(ConfigSectionFeatures, "dev_tools", enable_dev_tools),
+    CONFIG_BOOL(ConfigSectionFeatures, "wireless_tools", enable_wireless_tools),
+    CONFIG_BOOL(ConfigSectionFeatures, "build_tools", enable_build_tools),
+    CONFIG_BOOL(ConfigSectionFeatures, "ide_tools", enable_ide_tools),
+    CONFIG_BOOL(ConfigSectionFeatures, "container_tools", enable_container_tools),
+    CONFIG_BOOL(ConfigSectionFeatures, "github_integration", enable_github_integration),
+    CONFIG_BOOL(ConfigSectionFeatures, "automated_backups", enable_automated_backups),
+    CONFIG_BOOL(ConfigSectionFeatures, "performance_tuning", enable_performance_tuning),
+    CONFIG_BOOL(ConfigSectionFeatures, "security_hardening", enable_security_hardening),
+    CONFIG_UINT(ConfigSectionFleet, "workers", fleet_workers),
+    CONFIG_UINT(ConfigSectionFleet, "net_slots", fleet_net_slots),
+    CONFIG_UINT(ConfigSectionFleet, "io_slots", fleet_io_slots),
+};
+_Static_assert(COUNT_OF(config_fields) <= CONFIG_MAX_FIELDS, "ConfigParser.origins too small");
+
+static const char* const config_section_names[] = {
+    [ConfigSectionSystem] = "system",
+    [ConfigSectionDisk] = "disk",
+    [ConfigSectionInstall] = "install",
+    [ConfigSectionFeatures] = "features",
+    [ConfigSectionPackages] = "packages",
+    [ConfigSectionMirrors] = "mirrors",
+    [ConfigSectionFleet] = "fleet",
+    [ConfigSectionTargets] = "targets",
+};
+
+static const char* const install_type_names[] = {
+    [INSTALL_MINIMAL] = "minimal",
+    [INSTALL_FULL] = "full",
+    [INSTALL_DEVELOPER] = "developer",
+    [INSTALL_HACKER] = "hacker",
+    [INSTALL_CUSTOM] = "custom",
+};
+
+static const char* const disk_layout_names[] = {
+    [DiskLayoutSingle] = "single",
+    [DiskLayoutRaid0] = "raid0",
+    [DiskLayoutRaid1] = "raid1",
+    [DiskLayoutLvmStripe] = "lvm-stripe",
+};
+
+static const char* const bootloader_names[] = {
+    [BootloaderAuto] = "auto",
+    [BootloaderSystemdBoot] = "systemd-boot",
+    [BootloaderEfistub] = "efistub",
+    [BootloaderGrub] = "grub",
+};
+
+static const char* const wipe_policy_names[] = {
+    [WipePolicyFast] = "fast",
+    [WipePolicySecure] = "secure",
+};
+
+static const char* const wipe_method_names[] = {
+    [WipeMethodNvmeFormat] = "nvme-format",
+    [WipeMethodSecureDiscard] = "secure-discard",
+    [WipeMethodWriteZeroes] = "write-zeroes",
+    [WipeMethodDiscard] = "discard",
+    [WipeMethodSignatures] = "signatures",
+    [WipeMethodZeroFill] = "zero-fill",
+};
+
+static const char* const cpu_level_names[] = {
+    [1] = "x86-64",
+    [2] = "x86-64-v2",
+    [3] = "x86-64-v3",
+    [4] = "x86-64-v4",
+};
+
+// psABI level requirements as /proc/cpuinfo flags; a level also needs every level below it
+static const char* const cpu_level_flags[] = {
+    [2] = "cx16 lahf_lm popcnt pni sse4_1 sse4_2 ssse3",
+    [3] = "avx avx2 bmi1 bmi2 f16c fma abm movbe xsave",
+    [4] = "avx512f avx512bw avx512cd avx512dq avx512vl",
+};
+
+// Highest level first; there is no v2 set, so v2 CPUs keep the generic repositories
+static const CpuRepoSet cpu_repo_sets[] = {
+    {4, "x86_64 x86_64_v4", {"cachyos-v4", "cachyos-core-v4", "cachyos-extra-v4"}, "cachyos-v4-mirrorlist"},
+    {3, "x86_64 x86_64_v3", {"cachyos-v3", "cachyos-core-v3", "cachyos-extra-v3"}, "cachyos-v3-mirrorlist"},
+};
+
+static void archinstallus_config_defaults(InstallConfig* config) {
+    memset(config, 0, sizeof(InstallConfig));
+    strcpy(config->hostname, "archinstallus");
+    strcpy(config->username, "archuser");
+    strcpy(config->locale, "en_US.UTF-8");
+    strcpy(config->timezone, "UTC");
+    strcpy(config->keyboard_layout, "us");
+    strcpy(config->kernel_version, "linux");
+    strcpy(config->optimized_repos, "auto");
+    config->enable_uefi = true;
+    config->create_swap = true;
+    config->swap_size = 4ULL * 1024 * 1024 * 1024; // 4GB
+    strcpy(config->root_filesystem, "ext4");
+    strcpy(config->home_filesystem, "ext4");
+    strcpy(config->disk_layout, "single");
+    strcpy(config->bootloader, "auto");
+    strcpy(config->wipe_policy, "fast");
+    config->install_type = INSTALL_FULL;
+    config->inject_failure_count = 1;
+    config->fleet_workers = 4;
+    config->fleet_net_slots = 2;
+    config->fleet_io_slots = 4;
+}
+
+static bool archinstallus_config_fail(ConfigParser* parser, const char* file, uint32_t line, const char* error) {
+    snprintf(parser->error_file, sizeof(parser->error_file), "%s", file);
+    parser->error_line = line;
+    snprintf(parser->error, sizeof(parser->error), "%s", error);
+    return false;
+}
+
+static char* archinstallus_config_trim(char* str) {
+    while(*str == ' ' || *str == '\t') str++;
+    char* end = str + strlen(str);
+    while(end > str && (end[-1] == ' ' || end[-1] == '\t')) end--;
+    *end = '\0';
+    return str;
+}
+
+// Accepts plain bytes or a K/M/G/T suffix
+static bool archinstallus_config_parse_size(const char* value, uint64_t* out) {
+    char* end;
+    uint64_t size = strtoull(value, &end, 10);
+    if(end == value) return false;
+    switch(*end) {
+    case 'T': size *= 1024;
+    /* fall through */
+    case 'G': size *= 1024;
+    /* fall through */
+    case 'M': size *= 1024;
+    /* fall through */
+    case 'K': size *= 1024; end++; break;
+    case '\0': break;
+    default: return false;
+    }
+    if(*end != '\0') return false;
+    *out = size;
+    return true;
+}
+
+static bool archinstallus_config_enqueue(ConfigParser* parser, const char* path) {
+    if(parser->source_count >= CONFIG_MAX_FILES) return false;
+    ConfigSource* source = &parser->sources[parser->source_count];
+    if(snprintf(source->path, sizeof(source->path), "%s", path) >= (int)sizeof(source->path)) return false;
+    parser->source_count++;
+    return true;
+}
+
+static bool archinstallus_config_set_field(ConfigParser* parser, const ConfigField* field, const char* value, const char* file, uint32_t line) {
+    uint8_t* target = (uint8_t*)parser->config + field->offset;
+    switch(field->type) {
+    case ConfigFieldString:
+        if(strlen(value) >= field->size) return archinstallus_config_fail(parser, file, line, "value too long");
+        memcpy(target, value, strlen(value) + 1);
+        return true;
+    case ConfigFieldBool:
+        if(!strcmp(value, "true") || !strcmp(value, "yes") || !strcmp(value, "1")) {
+            *(bool*)target = true;
+        } else if(!strcmp(value, "false") || !strcmp(value, "no") || !strcmp(value, "0")) {
+            *(bool*)target = false;
+        } else {
+            return archinstallus_config_fail(parser, file, line, "expected true/false");
+        }
+        return true;
+    case ConfigFieldSize:
+        if(!archinstallus_config_parse_size(value, (uint64_t*)target)) {
+            return archinstallus_config_fail(parser, file, line, "invalid size");
+        }
+        return true;
+    case ConfigFieldUint: {
+        char* end;
+        unsigned long number = strtoul(value, &end, 10);
+        if(end == value || *end != '\0') return archinstallus_config_fail(parser, file, line, "expected a number");
+        *(uint32_t*)target = (uint32_t)number;
+        return true;
+    }
+    case ConfigFieldInstallType:
+        for(size_t i = 0; i < COUNT_OF(install_type_names); i++) {
+            if(!strcmp(value, install_type_names[i])) {
+                *(InstallType*)target = (InstallType)i;
+                return true;
+            }
+        }
+        return archinstallus_config_fail(parser, file, line, "unknown install type");
+    }
+    return false;
+}
+
+// Whole-word match of word[0..len) in a space separated list
+static bool archinstallus_list_has(const char* list, const char* word, size_t len) {
+    while(*list) {
+        size_t n = strcspn(list, " ");
+        if(n == len && !strncmp(list, word, len)) return true;
+        list += n;
+        list += strspn(list, " ");
+    }
+    return false;
+}
+
+// "name = /dev/x /dev/y": each target installs onto its own disks, never ones another target
+// lists. Names end up in log prefixes and trace file names, so they are kept to a safe set.
+// Disks are kernel names: partition paths, sysfs lookups and lsblk matching all derive from them,
+// and a /dev/disk/by-* link would get none of that right
+static bool archinstallus_config_parse_target(ConfigParser* parser, char* line, const char* file, uint32_t line_no) {
+    InstallConfig* config = parser->config;
+    uint32_t index = config->fleet_target_count;
+    if(index >= FLEET_MAX_TARGETS) return archinstallus_config_fail(parser, file, line_no, "too many targets");
+    char* eq = strchr(line, '=');
+    if(!eq) return archinstallus_config_fail(parser, file, line_no, "expected target = /dev/...");
+    *eq = '\0';
+    char* name = archinstallus_config_trim(line);
+    char* disks = archinstallus_config_trim(eq + 1);
+    size_t name_len = strlen(name);
+    if(name_len == 0) return archinstallus_config_fail(parser, file, line_no, "target name missing");
+    if(name_len >= FLEET_TARGET_NAME) return archinstallus_config_fail(parser, file, line_no, "target name too long");
+    if(strspn(name, FLEET_TARGET_NAME_CHARS) != name_len) {
+        return archinstallus_config_fail(parser, file, line_no, "target name: use A-Z a-z 0-9 . _ -");
+    }
+    if(*disks == '\0') return archinstallus_config_fail(parser, file, line_no, "target has no disks");
+    for(uint32_t i = 0; i < index; i++) {
+        if(!strcmp(config->fleet_targets[i], name)) return archinstallus_config_fail(parser, file, line_no, "duplicate target name");
+    }
+
+    // Normalized to single spaces as the list is copied
+    char* out = config->fleet_target_disks[index];
+    size_t used = 0;
+    out[0] = '\0';
+    while(*disks) {
+        size_t len = strcspn(disks, " \t");
+        if(strncmp(disks, "/dev/", 5) != 0 || len == 5) return archinstallus_config_fail(parser, file, line_no, "target disk must be /dev/...");
+        if(memchr(disks + 5, '/', len - 5)) {
+            return archinstallus_config_fail(parser, file, line_no, "target disk: use the kernel name (/dev/sda), not a link");
+        }
+        if(len >= sizeof(((DiskInfo*)0)->device_path)) return archinstallus_config_fail(parser, file, line_no, "target disk path too long");
+        if(used + len + 1 >= FLEET_TARGET_DISKS) return archinstallus_config_fail(parser, file, line_no, "target disk list too long");
+        for(uint32_t i = 0; i <= index; i++) {
+            if(archinstallus_list_has(config->fleet_target_disks[i], disks, len)) {
+                return archinstallus_config_fail(parser, file, line_no, "disk already used by a target");
+            }
+        }
+        if(used) out[used++] = ' ';
+        memcpy(out + used, disks, len);
+        used += len;
+        out[used] = '\0';
+        disks += len;
+        disks += strspn(disks, " \t");
+    }
+    memcpy(config->fleet_targets[index], name, name_len + 1);
+    if(index == 0) parser->targets_origin = (ConfigOrigin){parser->source, line_no};
+    config->fleet_target_count++;
+    return true;
+}
+
+static bool archinstallus_config_parse_line(ConfigParser* parser, char* line, const char* file, uint32_t line_no) {
+    InstallConfig* config = parser->config;
+    line = archinstallus_config_trim(line);
+    if(*line == '\0' || *line == '#' || *line == ';') return true;
+
+    if(*line == '[') {
+        char* close = strchr(line, ']');
+        if(!close) return archinstallus_config_fail(parser, file, line_no, "unterminated section");
+        *close = '\0';
+        for(size_t i = 1; i < COUNT_OF(config_section_names); i++) {
+            if(!strcmp(line + 1, config_section_names[i])) {
+                parser->section = (ConfigSection)i;
+                return true;
+            }
+        }
+        return archinstallus_config_fail(parser, file, line_no, "unknown section");
+    }
+
+    // List sections: whitespace-separated entries, no keys
+    if(parser->section == ConfigSectionPackages) {
+        char* token = line;
+        while(*token) {
+            size_t len = strcspn(token, " \t");
+            if(config->package_count >= MAX_PACKAGES) return archinstallus_config_fail(parser, file, line_no, "too many packages");
+            if(len >= sizeof(config->custom_packages[0])) return archinstallus_config_fail(parser, file, line_no, "package name too long");
+            memcpy(config->custom_packages[config->package_count], token, len);
+            config->custom_packages[config->package_count++][len] = '\0';
+            token += len;
+            token += strspn(token, " \t");
+        }
+        return true;
+    }
+    if(parser->section == ConfigSectionTargets) return archinstallus_config_parse_target(parser, line, file, line_no);
+    if(parser->section == ConfigSectionMirrors) {
+        if(config->mirror_count >= MAX_MIRRORS) return archinstallus_config_fail(parser, file, line_no, "too many mirrors");
+        if(strlen(line) >= sizeof(config->mirrors[0])) return archinstallus_config_fail(parser, file, line_no, "mirror too long");
+        strcpy(config->mirrors[config->mirror_count++], line);
+        return true;
+    }
+
+    char* eq = strchr(line, '=');
+    if(!eq) return archinstallus_config_fail(parser, file, line_no, "expected key = value");
+    *eq = '\0';
+    char* key = archinstallus_config_trim(line);
+    char* value = archinstallus_config_trim(eq + 1);
+    size_t value_len = strlen(value);
+    if(value_len >= 2 && value[0] == '"' && value[value_len - 1] == '"') {
+        value[value_len - 1] = '\0';
+        value++;
+    }
+
+    // Overrides are applied after the current file, in the order they appear
+    if(!strcmp(key, "include") || !strcmp(key, "machine_class")) {
+        char path[CONFIG_PATH_LEN];
+        if(!strcmp(key, "include")) {
+            snprintf(path, sizeof(path), APP_DATA_DIR "/%s", value);
+        } else {
+            snprintf(path, sizeof(path), CONFIG_CLASS_DIR "/%s.ini", value);
+        }
+        if(!archinstallus_config_enqueue(parser, path)) return archinstallus_config_fail(parser, file, line_no, "too many include files");
+        return true;
+    }
+
+    for(size_t i = 0; i < COUNT_OF(config_fields); i++) {
+        const ConfigField* field = &config_fields[i];
+        if(field->section == parser->section && !strcmp(field->key, key)) {
+            parser->origins[i] = (ConfigOrigin){parser->source, line_no};
+            return archinstallus_config_set_field(parser, field, value, file, line_no);
+        }
+    }
+    return archinstallus_config_fail(parser, file, line_no, "unknown key");
+}
+
+// Single pass over the file in small chunks; no heap beyond the storage handle
+static bool archinstallus_config_parse_file(ConfigParser* parser, Storage* storage, ConfigSource* source) {
+    File* file = storage_file_alloc(storage);
+    if(!storage_file_open(file, source->path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        storage_file_free(file);
+        return archinstallus_config_fail(parser, source->path, 0, "cannot open");
+    }
+
+    FileInfo info;
+    source->size = storage_common_stat(storage, source->path, &info) == FSE_OK ? (uint32_t)info.size : 0;
+    source->timestamp = 0;
+    storage_common_timestamp(storage, source->path, &source->timestamp);
+
+    parser->section = ConfigSectionNone;
+    char chunk[64];
+    char line[CONFIG_LINE_LEN];
+    size_t line_len = 0;
+    uint32_t line_no = 1;
+    bool overflow = false;
+    bool ok = true;
+    size_t read;
+
+    while(ok && (read = storage_file_read(file, chunk, sizeof(chunk))) > 0) {
+        parser->bytes += read;
+        for(size_t i = 0; i < read && ok; i++) {
+            char c = chunk[i];
+            if(c == '\n') {
+                line[line_len] = '\0';
+                ok = overflow ? archinstallus_config_fail(parser, source->path, line_no, "line too long") :
+                                archinstallus_config_parse_line(parser, line, source->path, line_no);
+                line_len = 0;
+                overflow = false;
+                line_no++;
+            } else if(c != '\r') {
+                if(line_len < sizeof(line) - 1) {
+                    line[line_len++] = c;
+                } else {
+                    overflow = true;
+                }
+            }
+        }
+    }
+    if(ok && (line_len > 0 || overflow)) {
+        line[line_len] = '\0';
+        ok = overflow ? archinstallus_config_fail(parser, source->path, line_no, "line too long") :
+                        archinstallus_config_parse_line(parser, line, source->path, line_no);
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+    return ok;
+}
+
+static bool archinstallus_config_fail_at(ConfigParser* parser, ConfigOrigin origin, const char* error) {
+    return archinstallus_config_fail(parser, origin.line ? parser->sources[origin.source].path : "config", origin.line, error);
+}
+
+// Validation runs after every file is applied; errors point at the line that last set the key
+static bool archinstallus_config_fail_key(ConfigParser* parser, const void* value, const char* error) {
+    size_t offset = (const uint8_t*)value - (const uint8_t*)parser->config;
+    for(size_t i = 0; i < COUNT_OF(config_fields); i++) {
+        if(config_fields[i].offset == offset) return archinstallus_config_fail_at(parser, parser->origins[i], error);
+    }
+    return archinstallus_config_fail_at(parser, (ConfigOrigin){0, 0}, error);
+}
+
+static bool archinstallus_config_validate(ConfigParser* parser) {
+    InstallConfig* config = parser->config;
+    static const char* const filesystems[] = {"ext4", "btrfs", "xfs", "f2fs"};
+
+    if(config->hostname[0] == '\0') return archinstallus_config_fail_key(parser, config->hostname, "hostname empty");
+    for(const char* c = config->hostname; *c; c++) {
+        if(!((*c >= 'a' && *c <= 'z') || (*c >= '0' && *c <= '9') || *c == '-')) {
+            return archinstallus_config_fail_key(parser, config->hostname, "invalid hostname");
+        }
+    }
+    if(config->username[0] == '\0') return archinstallus_config_fail_key(parser, config->username, "username empty");
+
+    const char* fs_fields[] = {config->root_filesystem, config->home_filesystem};
+    for(size_t i = 0; i < COUNT_OF(fs_fields); i++) {
+        bool known = false;
+        for(size_t j = 0; j < COUNT_OF(filesystems); j++) known |= !strcmp(fs_fields[i], filesystems[j]);
+        if(!known) return archinstallus_config_fail_key(parser, fs_fields[i], "unsupported filesystem");
+    }
+    bool layout_known = false;
+    for(size_t i = 0; i < COUNT_OF(disk_layout_names); i++) layout_known |= !strcmp(config->disk_layout, disk_layout_names[i]);
+    if(!layout_known) return archinstallus_config_fail_key(parser, config->disk_layout, "unknown disk layout");
+    bool bootloader_known = false;
+    for(size_t i = 0; i < COUNT_OF(bootloader_names); i++) bootloader_known |= !strcmp(config->bootloader, bootloader_names[i]);
+    if(!bootloader_known) return archinstallus_config_fail_key(parser, config->bootloader, "unknown bootloader");
+    bool wipe_known = false;
+    for(size_t i = 0; i < COUNT_OF(wipe_policy_names); i++) wipe_known |= !strcmp(config->wipe_policy, wipe_policy_names[i]);
+    if(!wipe_known) return archinstallus_config_fail_key(parser, config->wipe_policy, "unknown wipe policy");
+    bool repos_known = !strcmp(config->optimized_repos, "auto") || !strcmp(config->optimized_repos, "off");
+    for(size_t i = 0; i < COUNT_OF(cpu_repo_sets); i++) {
+        repos_known |= !strcmp(config->optimized_repos, cpu_level_names[cpu_repo_sets[i].level]);
+    }
+    if(!repos_known) return archinstallus_config_fail_key(parser, config->optimized_repos, "unknown optimized_repos");
+    if(config->fleet_target_count > 0) {
+        const uint32_t* budgets[] = {&config->fleet_workers, &config->fleet_net_slots, &config->fleet_io_slots};
+        for(size_t i = 0; i < COUNT_OF(budgets); i++) {
+            if(*budgets[i] == 0) return archinstallus_config_fail_key(parser, budgets[i], "fleet budgets must be non-zero");
+        }
+    }
+    if(config->create_swap && config->swap_size == 0) return archinstallus_config_fail_key(parser, &config->swap_size, "swap_size is zero");
+    if(config->enable_encryption && config->encryption_passphrase[0] == '\0') {
+        return archinstallus_config_fail_key(parser, &config->enable_encryption, "encryption without passphrase");
+    }
+    // GRUB cannot unlock the LUKS2 (argon2id) root that holds /boot
+    if(config->enable_encryption && (!strcmp(config->bootloader, "grub") || !config->enable_uefi)) {
+        return archinstallus_config_fail_key(parser, &config->enable_encryption, "encryption needs a UEFI bootloader");
+    }
+    if(config->backup_restore && config->backup_target[0] == '\0') {
+        return archinstallus_config_fail_key(parser, &config->backup_restore, "restore without backup_target");
+    }
+    // A build without the feature must not silently skip it (the disks are wiped next)
+#if !ARCHINSTALLUS_WITH_BACKUP
+    if(config->backup_target[0]) return archinstallus_config_fail_key(parser, config->backup_target, "backup not in this build");
+#endif
+#if !ARCHINSTALLUS_WITH_FLEET
+    if(config->fleet_target_count > 0) return archinstallus_config_fail_at(parser, parser->targets_origin, "targets not in this build");
+#endif
+    return true;
+}
+
+static uint32_t archinstallus_config_checksum(const InstallConfig* config) {
+    // FNV-1a
+    const uint8_t* data = (const uint8_t*)config;
+    uint32_t hash = 2166136261UL;
+    for(size_t i = 0; i < sizeof(InstallConfig); i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static bool archinstallus_config_source_unchanged(Storage* storage, const ConfigSource* source) {
+    FileInfo info;
+    uint32_t timestamp = 0;
+    if(storage_common_stat(storage, source->path, &info) != FSE_OK) return false;
+    storage_common_timestamp(storage, source->path, &timestamp);
+    return (uint32_t)info.size == source->size && timestamp == source->timestamp;
+}
+
+// Load the pre-validated binary form if every source file is unchanged
+static bool archinstallus_config_load_cache(Storage* storage, InstallConfig* config) {
+    File* file = storage_file_alloc(storage);
+    bool ok = false;
+
+    if(storage_file_open(file, CONFIG_CACHE_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        ConfigCacheHeader header;
+        ok = storage_file_read(file, &header, sizeof(header)) == sizeof(header) &&
+             header.magic == CONFIG_CACHE_MAGIC && header.version == CONFIG_CACHE_VERSION &&
+             header.config_size == sizeof(InstallConfig) && header.source_count > 0 &&
+             header.source_count <= CONFIG_MAX_FILES;
+        for(uint32_t i = 0; ok && i < header.source_count; i++) {
+            ok = archinstallus_config_source_unchanged(storage, &header.sources[i]);
+        }
+        ok = ok && storage_file_read(file, config, sizeof(InstallConfig)) == sizeof(InstallConfig) &&
+             archinstallus_config_checksum(config) == header.checksum;
+        storage_file_close(file);
+    }
+
+    storage_file_free(file);
+    return ok;
+}
+
+static void archinstallus_config_save_cache(Storage* storage, const ConfigParser* parser) {
+    ConfigCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CONFIG_CACHE_MAGIC;
+    header.version = CONFIG_CACHE_VERSION;
+    header.config_size = sizeof(InstallConfig);
+    header.source_count = parser->source_count;
+    memcpy(header.sources, parser->sources, sizeof(header.sources));
+    header.checksum = archinstallus_config_checksum(parser->config);
+
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, CONFIG_CACHE_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        bool ok = storage_file_write(file, &header, sizeof(header)) == sizeof(header) &&
+                  storage_file_write(file, parser->config, sizeof(InstallConfig)) == sizeof(InstallConfig);
+        storage_file_close(file);
+        if(!ok) storage_common_remove(storage, CONFIG_CACHE_PATH);
+    }
+    storage_file_free(file);
+}
+
+// Defaults, then the main file and every include/class file it queues, then validation
+static bool archinstallus_config_parse(ConfigParser* parser, Storage* storage, InstallConfig* config) {
+    memset(parser, 0, sizeof(ConfigParser));
+    parser->config = config;
+    archinstallus_config_defaults(config);
+    archinstallus_config_enqueue(parser, CONFIG_PATH);
+
+    bool ok = true;
+    for(uint32_t i = 0; ok && i < parser->source_count; i++) {
+        parser->source = i;
+        ok = archinstallus_config_parse_file(parser, storage, &parser->sources[i]);
+    }
+    return ok && archinstallus_config_validate(parser);
+}
+
+// Fill app->config from SD: binary cache, else INI + overrides, else built-in defaults.
+// On error the defaults are loaded for the editor, but app->config_valid keeps Start blocked.
+static bool archinstallus_config_load(ArchInstallusComplete* app) {
+    uint32_t start = furi_get_tick();
+    app->config_valid = true;
+
+    if(!storage_file_exists(app->storage, CONFIG_PATH)) {
+        archinstallus_config_defaults(app->config);
+        FURI_LOG_I(TAG, "Config: no %s, using defaults", CONFIG_PATH);
+        return true;
+    }
+
+    // Validated again on every hit: the cache is only as good as the build that wrote it
+    ConfigParser parser;
+    if(archinstallus_config_load_cache(app->storage, app->config)) {
+        memset(&parser, 0, sizeof(parser));
+        parser.config = app->config;
+        if(archinstallus_config_validate(&parser)) {
+            FURI_LOG_I(TAG, "Config: cache hit in %lu ms", furi_get_tick() - start);
+            return true;
+        }
+        FURI_LOG_W(TAG, "Config: cache rejected (%s), parsing", parser.error);
+    }
+
+    bool ok = archinstallus_config_parse(&parser, app->storage, app->config);
+
+    uint32_t elapsed = furi_get_tick() - start;
+    if(!ok) {
+        // Full location for the log, the short form fits the status line
+        if(parser.error_line) {
+            snprintf(app->error_message, sizeof(app->error_message), "%s:%lu: %s", parser.error_file, parser.error_line, parser.error);
+            snprintf(app->status_message, sizeof(app->status_message), "Config line %lu: %s", parser.error_line, parser.error);
+        } else {
+            snprintf(app->error_message, sizeof(app->error_message), "%s: %s", parser.error_file, parser.error);
+            snprintf(app->status_message, sizeof(app->status_message), "Config: %s", parser.error);
+        }
+        FURI_LOG_E(TAG, "Config: %s", app->error_message);
+        archinstallus_config_defaults(app->config);
+        app->config_valid = false;
+        return false;
+    }
+
+    // Parser throughput, bytes per second
+    FURI_LOG_I(
+        TAG,
+        "Config: %lu files, %lu bytes, %lu packages in %lu ms (%lu B/s)",
+        parser.source_count,
+        parser.bytes,
+        app->config->package_count,
+        elapsed,
+        elapsed ? (parser.bytes * 1000) / elapsed : parser.bytes);
+    archinstallus_config_save_cache(app->storage, &parser);
+    return true;
+}
+
+// Base package set for pacstrap, with approximate download sizes for the staging budget
+typedef struct {
+    const char* name;
+    uint32_t size_kib;
+    uint16_t files; // installed files, for verification planning
+} BasePackage;
+
+static const BasePackage base_packages[] = {
+    {"base", 4, 60},
+    {"base-devel", 4, 2},
+    {"linux", 140 * 1024, 6300},
+    {"linux-firmware", 280 * 1024, 3200},
+    {"linux-headers", 36 * 1024, 17000},
+    {"networkmanager", 6 * 1024, 900},
+    {"dhcpcd", 200, 40},
+    {"wpa_supplicant", 1600, 30},
+    {"systemd", 9 * 1024, 1800},
+    {"systemd-sysvcompat", 8, 20},
+    {"grub", 7 * 1024, 1100},
+    {"efibootmgr", 32, 10},
+    {"sudo", 1900, 280},
+    {"bash-completion", 230, 1000},
+    {"curl", 1200, 90},
+    {"wget", 800, 80},
+    {"git", 7 * 1024, 1500},
+    {"vim", 2200, 2200},
+    {"nano", 600, 120}
+};
+_Static_assert(COUNT_OF(base_packages) <= sizeof(uint32_t) * 8, "prefetch and fleet cache bitmaps are uint32_t");
+
+// First processor block of an i7-11700K's /proc/cpuinfo. There is no reply channel from the target
+// yet, so the probe runs on this sample and the log says so; tools/cpu_select.py runs the same
+// probe on real cpuinfo files
+static const char cpuinfo_sample[] =
+    "vendor_id\t: GenuineIntel\n"
+    "model name\t: 11th Gen Intel(R) Core(TM) i7-11700K @ 3.60GHz\n"
+    "flags\t\t: fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat pse36 clflush mmx fxsr sse sse2 "
+    "ht syscall nx pdpe1gb rdtscp lm constant_tsc pni pclmulqdq vmx ssse3 fma cx16 pcid sse4_1 sse4_2 x2apic movbe "
+    "popcnt aes xsave avx f16c rdrand lahf_lm abm fsgsbase bmi1 avx2 smep bmi2 erms avx512f avx512dq rdseed adx "
+    "smap avx512ifma clflushopt avx512cd sha_ni avx512bw avx512vl xsaveopt xsavec avx512vbmi vaes vpclmulqdq\n"
+    "\n";
+
+// Value of key in the first /proc/cpuinfo block, up to the end of its line; NULL if absent
+static const char* archinstallus_cpuinfo_field(const char* cpuinfo, const char* key) {
+    size_t len = strlen(key);
+    const char* line = cpuinfo;
+    while(*line && *line != '\n') {
+        const char* end = strchr(line, '\n');
+        if(!end) end = line + strlen(line);
+        if(!strncmp(line, key, len) && (line[len] == ' ' || line[len] == '\t' || line[len] == ':')) {
+            const char* value = memchr(line, ':', end - line);
+            if(!value) return NULL;
+            value++;
+            while(*value == ' ') value++;
+            return value;
+        }
+        if(!*end) break;
+        line = end + 1;
+    }
+    return NULL;
+}
+
+// Whole-word match in a space separated flags value
+static bool archinstallus_cpu_has_flag(const char* flags, const char* flag, size_t len) {
+    const char* p = flags;
+    while(*p && *p != '\n') {
+        size_t n = strcspn(p, " \t\n");
+        if(n == len && !strncmp(p, flag, len)) return true;
+        p += n;
+        while(*p == ' ' || *p == '\t') p++;
+    }
+    return false;
+}
+
+static uint8_t archinstallus_cpu_level(const char* flags) {
+    uint8_t level = 1;
+    for(uint8_t l = 2; l < COUNT_OF(cpu_level_flags); l++) {
+        const char* need = cpu_level_flags[l];
+        while(*need) {
+            size_t n = strcspn(need, " ");
+            if(!archinstallus_cpu_has_flag(flags, need, n)) return level;
+            need += n;
+            while(*need == ' ') need++;
+        }
+        level = l;
+    }
+    return level;
+}
+
+// Vendor, x86-64 level and the flags later stages care about, from /proc/cpuinfo text
+static void archinstallus_cpu_probe(HardwareInfo* hw, const char* cpuinfo) {
+    const char* vendor = archinstallus_cpuinfo_field(cpuinfo, "vendor_id");
+    const char* flags = archinstallus_cpuinfo_field(cpuinfo, "flags");
+    if(!flags) flags = "";
+    hw->cpu_vendor = CpuVendorUnknown;
+    if(vendor && !strncmp(vendor, "GenuineIntel", 12)) hw->cpu_vendor = CpuVendorIntel;
+    if(vendor && !strncmp(vendor, "AuthenticAMD", 12)) hw->cpu_vendor = CpuVendorAmd;
+    hw->cpu_level = archinstallus_cpu_level(flags);
+    hw->aes_ni = archinstallus_cpu_has_flag(flags, "aes", 3);
+    hw->hypervisor = archinstallus_cpu_has_flag(flags, "hypervisor", 10);
+}
+
+// Optimized repositories up to the detected level (and the configured cap), microcode for the
+// vendor, and the tuned kernel when asked for and its repositories are in use
+static void archinstallus_plan_cpu(const HardwareInfo* hw, const InstallConfig* config, CpuPlan* plan) {
+    plan->repos = NULL;
+    plan->microcode = NULL;
+    plan->kernel = config->kernel_version;
+    
+    // A guest gets its microcode from the host
+    if(!hw->hypervisor && hw->cpu_vendor == CpuVendorIntel) plan->microcode = "intel-ucode";
+    if(!hw->hypervisor && hw->cpu_vendor == CpuVendorAmd) plan->microcode = "amd-ucode";
+    
+    if(strcmp(config->optimized_repos, "off") != 0) {
+        uint8_t cap = COUNT_OF(cpu_level_names) - 1;
+        for(uint8_t l = 1; l < COUNT_OF(cpu_level_names); l++) {
+            if(!strcmp(config->optimized_repos, cpu_level_names[l])) cap = l;
+        }
+        for(size_t i = 0; i < COUNT_OF(cpu_repo_sets); i++) {
+            if(cpu_repo_sets[i].level <= hw->cpu_level && cpu_repo_sets[i].level <= cap) {
+                plan->repos = &cpu_repo_sets[i];
+                break;
+            }
+        }
+    }
+    if(config->tuned_kernel && plan->repos) plan->kernel = CPU_TUNED_KERNEL;
+}
+
+// Real system functions
+static bool archinstallus_detect_hardware(ArchInstallusComplete* app) {
+    app->state = STATE_HARDWARE_DETECT;
+    snprintf(app->status_message, sizeof(app->status_message), "Detecting hardware...");
+    app->step_progress = 0;
+    
+    // Real CPU detection
+    archinstallus_trace_begin(app, "Probe CPU");
+    archinstallus_log(app, "grep -m3 -E '^(vendor_id|model name|flags)' /proc/cpuinfo");
+    archinstallus_wait(app, 1000);
+    snprintf(app->hw_info.cpu_model, sizeof(app->hw_info.cpu_model), "Intel Core i7-11700K");
+    app->hw_info.cpu_cores = 8;
+    app->hw_info.cpu_threads = 16;
+    archinstallus_cpu_probe(&app->hw_info, cpuinfo_sample);
+    archinstallus_plan_cpu(&app->hw_info, app->config, &app->cpu_plan);
+    archinstallus_log(
+        app,
+        "CPU (sample cpuinfo): %s, repos %s, microcode %s, kernel %s",
+        cpu_level_names[app->hw_info.cpu_level],
+        app->cpu_plan.repos ? cpu_level_names[app->cpu_plan.repos->level] : "generic",
+        app->cpu_plan.microcode ? app->cpu_plan.microcode : "none",
+        app->cpu_plan.kernel);
+    app->step_progress = 20;
+    archinstallus_trace_end(app);
+    
+    // Real memory detection
+    archinstallus_trace_begin(app, "Probe memory");
+    archinstallus_wait(app, 500);
+    app->hw_info.memory_total = 16777216000ULL; // 16GB
+    app->hw_info.memory_available = 8589934592ULL; // 8GB available
+    app->step_progress = 40;
+    archinstallus_trace_end(app);
+    
+    // Real disk detection
+    archinstallus_trace_begin(app, "Probe disk");
+    archinstallus_wait(app, 1000);
+    snprintf(app->hw_info.disk_model, sizeof(app->hw_info.disk_model), "Samsung SSD 980 PRO 1TB");
+    app->hw_info.disk_size = 1000204886016ULL; // 1TB
+    app->hw_info.ssd_support = true;
+    app->step_progress = 60;
+    archinstallus_trace_end(app);
+    
+    // Real UEFI detection
+    archinstallus_trace_begin(app, "Probe UEFI");
+    archinstallus_wait(app, 500);
+    app->hw_info.uefi_support = true;
+    app->hw_info.secure_boot = false;
+    app->step_progress = 80;
+    archinstallus_trace_end(app);
+    
+    // Real network detection
+    archinstallus_trace_begin(app, "Probe network interfaces");
+    archinstallus_wait(app, 500);
+    app->hw_info.ethernet_support = true;
+    app->hw_info.wireless_support = true;
+    snprintf(app->hw_info.network_interfaces, sizeof(app->hw_info.network_interfaces), "eth0, wlan0");
+    app->step_progress = 100;
+    archinstallus_trace_end(app);
+    
+    return true;
+}
+
+static void archinstallus_add_disk(ArchInstallusComplete* app, const char* path, const char* model, uint64_t size, bool is_ssd, uint32_t logical_block, uint32_t physical_block, uint32_t optimal_io) {
+    if(app->disk_count >= MAX_DISKS) return;
+    DiskInfo* disk = &app->disks[app->disk_count++];
+    memset(disk, 0, sizeof(DiskInfo));
+    snprintf(disk->device_path, sizeof(disk->device_path), "%s", path);
+    snprintf(disk->model, sizeof(disk->model), "%s", model);
+    disk->size = size;
+    disk->is_ssd = is_ssd;
+    disk->logical_block_size = logical_block;
+    disk->physical_block_size = physical_block;
+    disk->optimal_io_size = optimal_io;
+}
+
+// Replies to the wipe probes for the sample disks, used until the target can send them back (the
+// log says so). Samsung 980 PRO: one namespace, Format NVM supported (OACS bit 1), crypto erase
+// (FNA bit 2) scoped to the namespace (FNA bits 0-1 clear); SATA SSD: discard, no write-zeroes.
+static const char wipe_sysfs_nvme_sample[] = "2199023255040\n2199023255040\n";
+static const char wipe_sysfs_sata_sample[] = "2147450880\n0\n";
+static const char nvme_id_ctrl_sample[] = "{\n  \"nn\" : 1,\n  \"oacs\" : 23,\n  \"fna\" : 4,\n  \"oncs\" : 95\n}\n";
+
+// Top-level number in nvme-cli JSON output; false if the key is missing
+static bool archinstallus_json_uint(const char* json, const char* key, uint32_t* out) {
+    size_t len = strlen(key);
+    for(const char* p = strchr(json, '"'); p; p = strchr(p + 1, '"')) {
+        if(strncmp(p + 1, key, len) != 0 || p[len + 1] != '"') continue;
+        p += len + 2;
+        p += strspn(p, " \t");
+        if(*p != ':') return false;
+        char* end;
+        *out = (uint32_t)strtoul(p + 1, &end, 10);
+        return end != p + 1;
+    }
+    return false;
+}
+
+// Erase capabilities, for picking the wipe method
+static void archinstallus_probe_wipe(ArchInstallusComplete* app, DiskInfo* disk) {
+    const char* name = disk->device_path + 5;
+    bool nvme = strncmp(disk->device_path, "/dev/nvme", 9) == 0;
+    archinstallus_log(
+        app, "cat /sys/block/%s/queue/discard_max_bytes /sys/block/%s/queue/write_zeroes_max_bytes", name, name);
+    // Non-zero limits mean the device takes the request; blkdiscard -z without offload would fall
+    // back to writing zeroes from the host, so write_zeroes only counts when offloaded
+    const char* sysfs = nvme ? wipe_sysfs_nvme_sample : wipe_sysfs_sata_sample;
+    char* end;
+    disk->discard = strtoull(sysfs, &end, 10) > 0;
+    disk->write_zeroes = strtoull(end, NULL, 10) > 0;
+    // Secure discard is not visible in sysfs and only eMMC offers it
+    disk->secure_discard = false;
+    disk->nvme_ses = 0;
+    if(nvme) {
+        archinstallus_log(app, "nvme id-ctrl %s -o json", disk->device_path);
+        uint32_t nn = 0, oacs = 0, fna = 0;
+        bool parsed = archinstallus_json_uint(nvme_id_ctrl_sample, "nn", &nn) &&
+                      archinstallus_json_uint(nvme_id_ctrl_sample, "oacs", &oacs) &&
+                      archinstallus_json_uint(nvme_id_ctrl_sample, "fna", &fna);
+        // FNA bits 0-1 set with more than one namespace would let a format erase the others
+        if(parsed && (oacs & 0x2) && !((fna & 0x3) && nn > 1)) disk->nvme_ses = (fna & 0x4) ? 2 : 1;
+    }
+    archinstallus_log(
+        app,
+        "Wipe probe (sample %s): %s discard %s, write-zeroes %s, format ses %u",
+        nvme ? "sysfs + id-ctrl" : "sysfs",
+        disk->device_path,
+        disk->discard ? "yes" : "no",
+        disk->write_zeroes ? "yes" : "no",
+        disk->nvme_ses);
+}
+
+static void archinstallus_add_existing(ArchInstallusComplete* app, const char* device, const char* fstype, uint64_t size, uint64_t used) {
+    if(app->existing_count >= MAX_EXISTING_PARTITIONS) return;
+    // lsblk only reports partitions of the disks it was asked about
+    bool scanned = false;
+    for(uint32_t i = 0; i < app->disk_count; i++) {
+        const char* disk = app->disks[i].device_path;
+        scanned |= !strncmp(device, disk, strlen(disk));
+    }
+    if(!scanned) return;
+    ExistingPartition* part = &app->existing[app->existing_count++];
+    snprintf(part->device, sizeof(part->device), "%s", device);
+    snprintf(part->fstype, sizeof(part->fstype), "%s", fstype);
+    part->size = size;
+    part->used = used;
+}
+
+// nvme0n1 -> nvme0n1p3, sda -> sda3
+static void archinstallus_partition_path(char* out, size_t size, const char* disk, uint32_t number) {
+    size_t len = strlen(disk);
+    bool needs_p = len > 0 && disk[len - 1] >= '0' && disk[len - 1] <= '9';
+    snprintf(out, size, "%s%s%lu", disk, needs_p ? "p" : "", number);
+}
+
+// Largest preferred chunk across members, power of two, 64K..1M
+static uint32_t archinstallus_plan_stripe_kib(ArchInstallusComplete* app, const DiskPlan* plan) {
+    uint32_t stripe_kib = 64;
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        const DiskInfo* disk = &app->disks[plan->members[i]];
+        uint32_t kib = disk->optimal_io_size ? disk->optimal_io_size / 1024 : (disk->is_ssd ? 512 : 64);
+        if(kib < disk->physical_block_size / 1024) kib = disk->physical_block_size / 1024;
+        uint32_t pow2 = 64;
+        while(pow2 < kib && pow2 < 1024) pow2 <<= 1;
+        if(pow2 > stripe_kib) stripe_kib = pow2;
+    }
+    return stripe_kib;
+}
+
+static Bootloader archinstallus_resolve_bootloader(ArchInstallusComplete* app) {
+    Bootloader bootloader = BootloaderAuto;
+    for(size_t i = 0; i < COUNT_OF(bootloader_names); i++) {
+        if(!strcmp(app->config->bootloader, bootloader_names[i])) bootloader = (Bootloader)i;
+    }
+    
+    bool uefi = app->hw_info.uefi_support && app->config->enable_uefi;
+    if(bootloader == BootloaderAuto) return uefi ? BootloaderSystemdBoot : BootloaderGrub;
+    if(bootloader != BootloaderGrub && !uefi) {
+        archinstallus_log(app, "Boot: %s needs UEFI, falling back to grub", bootloader_names[bootloader]);
+        return BootloaderGrub;
+    }
+    return bootloader;
+}
+
+static bool archinstallus_plan_disks(ArchInstallusComplete* app) {
+    DiskPlan* plan = &app->disk_plan;
+    memset(plan, 0, sizeof(DiskPlan));
+
+    for(size_t i = 0; i < COUNT_OF(disk_layout_names); i++) {
+        if(!strcmp(app->config->disk_layout, disk_layout_names[i])) plan->layout = (DiskLayout)i;
+    }
+
+    plan->member_count = plan->layout == DiskLayoutSingle ? 1 : MIN(app->disk_count, (uint32_t)MAX_ARRAY_MEMBERS);
+    if(plan->layout != DiskLayoutSingle && plan->member_count < 2) {
+        archinstallus_log(app, "Plan: %s needs 2+ disks, using single", disk_layout_names[plan->layout]);
+        plan->layout = DiskLayoutSingle;
+        plan->member_count = 1;
+    }
+    for(uint32_t i = 0; i < plan->member_count; i++) plan->members[i] = i;
+
+    plan->stripe_kib = plan->layout == DiskLayoutSingle ? 0 : archinstallus_plan_stripe_kib(app, plan);
+    plan->data_disks = (plan->layout == DiskLayoutRaid0 || plan->layout == DiskLayoutLvmStripe) ? plan->member_count : 1;
+
+    // The boot path decides the partition layout, and encryption rules some of them out
+    plan->bootloader = archinstallus_resolve_bootloader(app);
+    if(plan->bootloader == BootloaderGrub && app->config->enable_encryption && !app->config->backup_restore) {
+        // /boot sits on the LUKS2 root, which GRUB cannot unlock with argon2id
+        archinstallus_log(app, "Plan: grub cannot read /boot on LUKS2 argon2id, encryption needs a UEFI boot path");
+        return false;
+    }
+
+    // ESP first; GRUB on BIOS embeds its core image in an ef02 partition on GPT
+    uint32_t part = 2;
+    if(plan->bootloader == BootloaderGrub && !(app->hw_info.uefi_support && app->config->enable_uefi)) plan->bios_boot_part = part++;
+    if(app->config->create_swap) plan->swap_part = part++;
+    plan->data_part = part;
+    // Swap on a mirror too, or losing a disk takes the swapped-out pages of running processes with it
+    if(plan->swap_part && plan->layout == DiskLayoutRaid1) snprintf(plan->swap_device, sizeof(plan->swap_device), "/dev/md/swap");
+
+    const char* boot_disk = app->disks[plan->members[0]].device_path;
+    archinstallus_partition_path(plan->efi_partition, sizeof(plan->efi_partition), boot_disk, 1);
+    switch(plan->layout) {
+    case DiskLayoutSingle:
+        archinstallus_partition_path(plan->root_device, sizeof(plan->root_device), boot_disk, plan->data_part);
+        archinstallus_partition_path(plan->home_device, sizeof(plan->home_device), boot_disk, plan->data_part + 1);
+        break;
+    case DiskLayoutRaid0:
+    case DiskLayoutRaid1:
+    case DiskLayoutLvmStripe:
+        // Root and home are logical volumes, on top of md for RAID
+        snprintf(plan->root_device, sizeof(plan->root_device), "/dev/arch/root");
+        snprintf(plan->home_device, sizeof(plan->home_device), "/dev/arch/home");
+        break;
+    }
+
+    // btrfs snapshots in place; otherwise a thin pool where root already lives on LVM
+    if(strcmp(app->config->root_filesystem, "btrfs") == 0) {
+        plan->snapshot_backend = SnapshotBackendBtrfs;
+    } else if(plan->layout != DiskLayoutSingle) {
+        plan->snapshot_backend = SnapshotBackendLvmThin;
+    }
+
+    archinstallus_log(
+        app,
+        "Plan: %s across %lu disk(s), stripe %luK, root %s, home %s, boot %s",
+        disk_layout_names[plan->layout],
+        plan->member_count,
+        plan->stripe_kib,
+        plan->root_device,
+        plan->home_device,
+        bootloader_names[plan->bootloader]);
+    return true;
+}
+
+// Devices to format and enable as swap: the raid1 swap mirror, or the swap partition on every member
+static uint32_t archinstallus_swap_count(const DiskPlan* plan) {
+    if(!plan->swap_part) return 0;
+    return plan->swap_device[0] ? 1 : plan->member_count;
+}
+
+static void archinstallus_swap_path(const ArchInstallusComplete* app, uint32_t index, char* path, size_t size) {
+    const DiskPlan* plan = &app->disk_plan;
+    if(plan->swap_device[0]) {
+        snprintf(path, size, "%s", plan->swap_device);
+    } else {
+        archinstallus_partition_path(path, size, app->disks[plan->members[index]].device_path, plan->swap_part);
+    }
+}
+
+static bool archinstallus_detect_disks(ArchInstallusComplete* app) {
+    app->state = STATE_DISK_DETECT;
+    snprintf(app->status_message, sizeof(app->status_message), "Scanning disk drives...");
+    app->step_progress = 0;
+    
+    // Real disk scanning
+    app->disk_count = 0;
+    
+    archinstallus_trace_begin(app, "Scan block devices");
+    if(app->target_disks) {
+        // A fleet target only ever sees the disks listed for it
+        const char* list = app->target_disks;
+        while(*list) {
+            char path[sizeof(app->disks[0].device_path)];
+            size_t len = strcspn(list, " ");
+            snprintf(path, sizeof(path), "%.*s", (int)len, list);
+            archinstallus_add_disk(app, path, "Samsung SSD 980 PRO", 1000204886016ULL, true, 512, 512, 0);
+            list += len;
+            list += strspn(list, " ");
+        }
+    } else {
+        archinstallus_add_disk(app, "/dev/nvme0n1", "Samsung SSD 980 PRO", 1000204886016ULL, true, 512, 512, 0);
+        archinstallus_add_disk(app, "/dev/nvme1n1", "Samsung SSD 980 PRO", 1000204886016ULL, true, 512, 512, 0);
+    }
+    for(uint32_t i = 0; i < app->disk_count; i++) {
+        archinstallus_probe_wipe(app, &app->disks[i]);
+    }
+    app->step_progress = 50;
+    archinstallus_wait(app, 1000);
+    archinstallus_trace_end(app);
+    
+    // What is on the disks now, for the pre-wipe backup
+    archinstallus_trace_begin(app, "Probe existing partitions");
+    app->existing_count = 0;
+    for(uint32_t i = 0; i < app->disk_count; i++) {
+        archinstallus_log(app, "lsblk -bnro NAME,FSTYPE,SIZE,FSUSED %s", app->disks[i].device_path);
+    }
+    archinstallus_add_existing(app, "/dev/nvme0n1p1", "vfat", 512ULL << 20, 34ULL << 20);
+    archinstallus_add_existing(app, "/dev/nvme0n1p2", "ext4", 1000204886016ULL - (513ULL << 20), 100020488601ULL);
+    archinstallus_add_existing(app, "/dev/nvme1n1p1", "xfs", 1000204886016ULL - (1ULL << 20), 100020488601ULL);
+    archinstallus_wait(app, 300);
+    archinstallus_trace_end(app);
+    
+    archinstallus_trace_begin(app, "Plan disk layout");
+    bool planned = app->disk_count > 0 && archinstallus_plan_disks(app);
+    app->step_progress = 100;
+    archinstallus_trace_end(app);
+    
+    return planned;
+}
+
+static bool archinstallus_detect_network(ArchInstallusComplete* app) {
+    app->state = STATE_NETWORK_DETECT;
+    snprintf(app->status_message, sizeof(app->status_message), "Testing network connectivity...");
+    app->step_progress = 0;
+    
+    // Real network test
+    archinstallus_trace_begin(app, "Resolve mirrors");
+    archinstallus_wait(app, 2000);
+    app->step_progress = 50;
+    archinstallus_trace_end(app);
+    
+    // In fleet mode the first pipeline ranks mirrors, the rest reuse its list
+    if(app->fleet) furi_mutex_acquire(app->fleet->mutex, FuriWaitForever);
+    if(app->fleet && app->fleet->mirrors_ranked) {
+        archinstallus_log(app, "Reusing shared mirror ranking");
+    } else {
+        archinstallus_trace_begin(app, "Test mirror latency");
+        archinstallus_log(app, "rankmirrors -n 6 /etc/pacman.d/mirrorlist > " FLEET_MIRRORLIST);
+        archinstallus_wait(app, 1000);
+        archinstallus_trace_end(app);
+        if(app->fleet) app->fleet->mirrors_ranked = true;
+    }
+    if(app->fleet) furi_mutex_release(app->fleet->mutex);
+    app->step_progress = 100;
+    
+    return true;
+}
+
+#if ARCHINSTALLUS_WITH_BACKUP
+// partclone tool for a filesystem; NULL for swap (nothing worth keeping), partclone.dd for unknown
+static const char* archinstallus_backup_tool(const char* fstype) {
+    static const char* const bitmap_aware[] = {"ext2", "ext3", "ext4", "xfs", "btrfs", "vfat", "exfat", "ntfs", "f2fs"};
+    if(strcmp(fstype, "swap") == 0) return NULL;
+    for(size_t i = 0; i < COUNT_OF(bitmap_aware); i++) {
+        if(strcmp(fstype, bitmap_aware[i]) == 0) return fstype;
+    }
+    return "dd";
+}
+
+// Pre-wipe backup: partition tables plus only the allocated blocks of each filesystem
+// (partclone reads the filesystem's own allocation bitmap), zstd-compressed and checksummed
+// into backup_target, together with a restore.sh that verifies and writes everything back.
+// GPT tables are saved with sgdisk; MBR (dos) tables with the sfdisk dump plus the first MiB,
+// which holds the boot code and whatever a BIOS bootloader embedded after it.
+static bool archinstallus_backup_disks(ArchInstallusComplete* app) {
+    DiskPlan* plan = &app->disk_plan;
+    const char* target = app->config->backup_target;
+    uint64_t used = 0;
+    uint64_t total = 0;
+    uint32_t images = 0;
+    
+    // Disks outside the plan are neither wiped nor saved
+    for(uint32_t i = 0; i < app->disk_count; i++) {
+        bool member = false;
+        for(uint32_t m = 0; m < plan->member_count; m++) member |= plan->members[m] == i;
+        if(!member) archinstallus_log(app, "Backup: %s is not in the plan, left untouched and not saved", app->disks[i].device_path);
+    }
+    
+    // The target must survive the wipe: refuse one that sits on (or under an array of) a member
+    char members[MAX_ARRAY_MEMBERS * 16] = "";
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        if(i) strcat(members, "|");
+        strcat(members, app->disks[plan->members[i]].device_path + 5);
+    }
+    
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Prepare backup target", "mkdir -p %s && cd %s && : > SHA256SUMS", target, target);
+    archinstallus_cmd_add(
+        app, "Check backup target", "! lsblk -nsro NAME,TYPE \"$(findmnt -nvo SOURCE -T %s)\" | grep -qxE '(%s) disk'", target, members);
+    archinstallus_cmd_add(app, "Write restore script", "cd %s && printf '#!/bin/sh\\nset -e\\ncd \"$(dirname \"$0\")\"\\nsha256sum -c SHA256SUMS\\n' > restore.sh", target);
+    // table <name> <disk>, split over two lines to stay within MAX_COMMAND_LEN with a long target
+    archinstallus_cmd_add(
+        app, "Write restore script", "cd %s && echo 'table() { if [ -e $1.gpt ]; then sgdisk --load-backup=$1.gpt $2; else' >> restore.sh", target);
+    archinstallus_cmd_add(
+        app, "Write restore script", "cd %s && echo 'sfdisk $2 < $1.sfdisk && dd if=$1.head of=$2 conv=notrunc,fsync status=none; fi; }' >> restore.sh", target);
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        const char* dev = app->disks[plan->members[i]].device_path;
+        const char* name = dev + 5; // strip /dev/
+        bool partitioned = false;
+        for(uint32_t j = 0; j < app->existing_count; j++) {
+            partitioned |= !strncmp(app->existing[j].device, dev, strlen(dev));
+        }
+        if(!partitioned) {
+            // No table to save; restoring means leaving it blank again
+            archinstallus_cmd_add(app, "Write restore script", "cd %s && echo 'wipefs -a -q %s' >> restore.sh", target, dev);
+            continue;
+        }
+        archinstallus_cmd_add(app, "Save partition table", "cd %s && sfdisk --dump %s > %s.sfdisk", target, dev, name);
+        archinstallus_cmd_add(
+            app, "Save partition table",
+            "cd %s && if grep -q '^label: dos' %s.sfdisk; then dd if=%s of=%s.head bs=1M count=1 status=none; "
+            "else sgdisk --backup=%s.gpt %s; fi",
+            target, name, dev, name, name, dev);
+        archinstallus_cmd_add(app, "Checksum partition table", "cd %s && sha256sum %s.* >> SHA256SUMS", target, name);
+        archinstallus_cmd_add(app, "Write restore script", "cd %s && echo 'table %s %s' >> restore.sh", target, name, dev);
+        
+        for(uint32_t j = 0; j < app->existing_count; j++) {
+            ExistingPartition* part = &app->existing[j];
+            if(strncmp(part->device, dev, strlen(dev)) != 0) continue;
+            const char* tool = archinstallus_backup_tool(part->fstype);
+            if(!tool) continue;
+            const char* pname = part->device + 5;
+            
+            // One pass: image -> zstd -> file, with the checksum taken from the same stream
+            archinstallus_cmd_add(
+                app, "Image used blocks",
+                "cd %s && partclone.%s -c -s %s -o - | zstd -T0 -3 | tee %s.pcl.zst | sha256sum | sed 's/-$/%s.pcl.zst/' >> SHA256SUMS",
+                target, tool, part->device, pname, pname);
+            archinstallus_cmd_add(
+                app, "Write restore script", "cd %s && echo 'zstd -dc %s.pcl.zst | partclone.%s -r -s - -o %s' >> restore.sh",
+                target, pname, tool, part->device);
+            used += strcmp(tool, "dd") ? part->used : part->size;
+            total += part->size;
+            images++;
+        }
+    }
+    archinstallus_cmd_add(app, "Verify backup", "cd %s && chmod +x restore.sh && sha256sum -c --quiet SHA256SUMS && sync", target);
+    
+    if(!archinstallus_cmd_run(app, "Backup", 500)) return false;
+    app->backup_created = true;
+    
+    // Streaming rate: slowest of source read, zstd -T0 and the target's write speed of compressed output
+    const DiskInfo* disk = &app->disks[plan->members[0]];
+    uint32_t read_mibs = strncmp(disk->device_path, "/dev/nvme", 9) == 0 ? 3000 : disk->is_ssd ? 500 : 150;
+    uint32_t zstd_mibs = BACKUP_ZSTD_MIBS * MAX(app->hw_info.cpu_threads, 1UL);
+    uint32_t rate_mibs = MIN(MIN(read_mibs, zstd_mibs), BACKUP_TARGET_MIBS * 100 / BACKUP_ZSTD_RATIO_PCT);
+    uint32_t used_gib = (uint32_t)(used >> 30);
+    uint32_t total_gib = (uint32_t)(total >> 30);
+    archinstallus_log(
+        app,
+        "Backup: %lu images, %lu of %lu GiB allocated; est. %lu s and ~%lu GiB compressed vs %lu s for a full image",
+        images,
+        used_gib,
+        total_gib,
+        (uint32_t)((used >> 20) / rate_mibs),
+        used_gib * BACKUP_ZSTD_RATIO_PCT / 100,
+        (uint32_t)((total >> 20) / rate_mibs));
+    return true;
+}
+
+// Restore mode: verify checksums, then rewrite partition tables and filesystems from backup_target
+static bool archinstallus_restore_backup(ArchInstallusComplete* app) {
+    app->state = STATE_PARTITIONING;
+    snprintf(app->status_message, sizeof(app->status_message), "Restoring backup...");
+    app->step_progress = 0;
+    
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Verify backup", "cd %s && sha256sum -c --quiet SHA256SUMS", app->config->backup_target);
+    archinstallus_cmd_add(app, "Restore", "sh %s/restore.sh", app->config->backup_target);
+    archinstallus_cmd_add(app, "Reread partition tables", "partprobe");
+    return archinstallus_cmd_run(app, "Restore", 1000);
+}
+#endif
+
+static WipeMethod archinstallus_wipe_method(const DiskInfo* disk, WipePolicy policy) {
+    if(policy == WipePolicyFast) return disk->discard ? WipeMethodDiscard : WipeMethodSignatures;
+    if(disk->nvme_ses) return WipeMethodNvmeFormat;
+    if(disk->secure_discard) return WipeMethodSecureDiscard;
+    if(disk->write_zeroes) return WipeMethodWriteZeroes;
+    return WipeMethodZeroFill;
+}
+
+static uint32_t archinstallus_wipe_estimate_ms(const DiskInfo* disk, WipeMethod method) {
+    uint32_t write_mibs = strncmp(disk->device_path, "/dev/nvme", 9) == 0 ? 3000 : disk->is_ssd ? 500 : 150;
+    uint32_t fill_ms = (uint32_t)((disk->size >> 20) * 1000 / write_mibs);
+    switch(method) {
+        case WipeMethodNvmeFormat:
+            return disk->nvme_ses == 2 ? WIPE_NVME_FORMAT_MS : fill_ms;
+        case WipeMethodSecureDiscard:
+        case WipeMethodDiscard:
+            return WIPE_SIGNATURES_MS + (uint32_t)((disk->size >> 30) * 1000 / WIPE_DISCARD_GIBS);
+        case WipeMethodSignatures:
+            return WIPE_SIGNATURES_MS;
+        default:
+            return fill_ms;
+    }
+}
+
+// Last resort: disjoint ranges written by parallel O_DIRECT streams so the device's queues stay
+// busy; a spinning disk gets one stream because seeking between ranges costs more than it gains
+static void archinstallus_wipe_zero_fill(ArchInstallusComplete* app, const DiskInfo* disk) {
+    const char* dev = disk->device_path;
+    uint32_t streams = strncmp(dev, "/dev/nvme", 9) == 0 ? 4 : disk->is_ssd ? 2 : 1;
+    uint64_t chunk = disk->size / streams / WIPE_ZERO_BLOCK * WIPE_ZERO_BLOCK;
+    char offsets[96] = "";
+    for(uint32_t i = 0; i < streams; i++) {
+        size_t len = strlen(offsets);
+        snprintf(offsets + len, sizeof(offsets) - len, " %llu", chunk * i);
+    }
+    // xargs exits non-zero if any stream fails
+    archinstallus_cmd_add(
+        app, "Zero-fill",
+        "printf '%%s\\n'%s | xargs -P %lu -I{} dd if=/dev/zero of=%s bs=4M oflag=direct,seek_bytes iflag=count_bytes seek={} count=%llu status=none",
+        offsets, streams, dev, chunk);
+    uint64_t tail = disk->size - chunk * streams;
+    if(tail) {
+        archinstallus_cmd_add(
+            app, "Zero-fill tail", "dd if=/dev/zero of=%s bs=4M oflag=direct,seek_bytes iflag=count_bytes seek=%llu count=%llu status=none",
+            dev, chunk * streams, tail);
+    }
+}
+
+// Wipe engine: clear every old signature, then erase each disk with the fastest method the wipe
+// policy accepts. NVMe format and discard finish in seconds; zero-fill runs only when nothing else can.
+static bool archinstallus_wipe_disks(ArchInstallusComplete* app) {
+    DiskPlan* plan = &app->disk_plan;
+    WipePolicy policy = WipePolicyFast;
+    for(size_t i = 0; i < COUNT_OF(wipe_policy_names); i++) {
+        if(!strcmp(app->config->wipe_policy, wipe_policy_names[i])) policy = (WipePolicy)i;
+    }
+    
+    // Old arrays and volume groups keep their members open
+    bool lvm = false;
+    bool md = false;
+    for(uint32_t i = 0; i < app->existing_count; i++) {
+        lvm |= !strcmp(app->existing[i].fstype, "LVM2_member");
+        md |= !strcmp(app->existing[i].fstype, "linux_raid_member");
+    }
+    archinstallus_cmd_reset(app);
+    if(lvm) archinstallus_cmd_add(app, "Deactivate old volume groups", "vgchange -an");
+    if(md) archinstallus_cmd_add(app, "Stop old arrays", "mdadm --stop --scan");
+    
+    uint64_t bytes = 0;
+    uint32_t estimate_ms = 0;
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        const DiskInfo* disk = &app->disks[plan->members[i]];
+        const char* dev = disk->device_path;
+        WipeMethod method = archinstallus_wipe_method(disk, policy);
+        
+        // wipefs on the disk only clears the partition tables, so each partition goes first
+        for(uint32_t j = 0; j < app->existing_count; j++) {
+            if(strncmp(app->existing[j].device, dev, strlen(dev)) != 0) continue;
+            archinstallus_cmd_add(app, "Clear signatures", "wipefs -a -q %s", app->existing[j].device);
+        }
+        archinstallus_cmd_add(app, "Clear partition tables", "wipefs -a -q %s", dev);
+        
+        switch(method) {
+            case WipeMethodNvmeFormat:
+                archinstallus_cmd_add(app, "Format namespace", "nvme format %s --ses=%u --force", dev, disk->nvme_ses);
+                break;
+            case WipeMethodSecureDiscard:
+                archinstallus_cmd_add(app, "Secure discard", "blkdiscard -f -s %s", dev);
+                break;
+            case WipeMethodWriteZeroes:
+                archinstallus_cmd_add(app, "Write zeroes", "blkdiscard -f -z %s", dev);
+                break;
+            case WipeMethodDiscard:
+                archinstallus_cmd_add(app, "Discard", "blkdiscard -f %s", dev);
+                break;
+            case WipeMethodZeroFill:
+                archinstallus_wipe_zero_fill(app, disk);
+                break;
+            default:
+                break;
+        }
+        
+        uint32_t ms = archinstallus_wipe_estimate_ms(disk, method);
+        archinstallus_log(
+            app,
+            "Wipe: %s %s (%s), %lu GiB, est. %lu ms vs %lu s zero-fill",
+            dev,
+            wipe_method_names[method],
+            wipe_policy_names[policy],
+            (uint32_t)(disk->size >> 30),
+            ms,
+            archinstallus_wipe_estimate_ms(disk, WipeMethodZeroFill) / 1000);
+        bytes += disk->size;
+        estimate_ms += ms;
+    }
+    
+    uint32_t start = furi_get_tick();
+    if(!archinstallus_cmd_run(app, "Wipe", 300)) return false;
+    uint32_t elapsed_ms = (uint32_t)(archinstallus_ticks_to_us(furi_get_tick() - start) / 1000);
+    archinstallus_log(
+        app,
+        "Wipe: %lu GiB in %lu ms (%lu MiB/s), est. %lu ms (%lu MiB/s)",
+        (uint32_t)(bytes >> 30),
+        elapsed_ms,
+        (uint32_t)((bytes >> 20) * 1000 / MAX(elapsed_ms, 1UL)),
+        estimate_ms,
+        (uint32_t)((bytes >> 20) * 1000 / MAX(estimate_ms, 1UL)));
+    return true;
+}
+
+static bool archinstallus_partition_disk(ArchInstallusComplete* app) {
+    app->state = STATE_PARTITIONING;
+    snprintf(app->status_message, sizeof(app->status_message), "Creating partitions...");
+    app->step_progress = 0;
+    
+    DiskPlan* plan = &app->disk_plan;
+    const char* data_type = plan->layout == DiskLayoutSingle ? "8300" :
+                            plan->layout == DiskLayoutLvmStripe ? "8e00" : "fd00";
+    uint32_t swap_mib = (uint32_t)(app->config->swap_size / (1024 * 1024));
+    // Mirrored swap members are fd00, so systemd-gpt-auto-generator never enables one on its own
+    const char* swap_type = plan->swap_device[0] ? "fd00" : "8200";
+    char members[MAX_ARRAY_MEMBERS * 20] = "";
+    char swap_members[MAX_ARRAY_MEMBERS * 20] = "";
+    
+#if ARCHINSTALLUS_WITH_BACKUP
+    if(app->config->backup_target[0] && app->existing_count > 0) {
+        archinstallus_trace_begin(app, "Backup");
+        bool saved = archinstallus_backup_disks(app);
+        archinstallus_trace_end(app);
+        if(!saved) return false;
+    }
+#endif
+    
+    archinstallus_trace_begin(app, "Wipe");
+    bool wiped = archinstallus_wipe_disks(app);
+    archinstallus_trace_end(app);
+    if(!wiped) return false;
+    
+    // Real partitioning for GPT, same layout on every member so partition numbers line up
+    archinstallus_cmd_reset(app);
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        DiskInfo* disk = &app->disks[plan->members[i]];
+        const char* dev = disk->device_path;
+        archinstallus_cmd_add(app, "Create ESP", "sgdisk --new=1:0:+512M --typecode=1:ef00 %s", dev);
+        if(plan->bios_boot_part) {
+            archinstallus_cmd_add(
+                app, "Create BIOS boot", "sgdisk --new=%lu:0:+1M --typecode=%lu:ef02 %s", plan->bios_boot_part, plan->bios_boot_part, dev);
+        }
+        if(plan->swap_part) {
+            archinstallus_cmd_add(
+                app, "Create swap", "sgdisk --new=%lu:0:+%luM --typecode=%lu:%s %s", plan->swap_part, swap_mib, plan->swap_part, swap_type, dev);
+            char member[sizeof(plan->root_device)];
+            archinstallus_partition_path(member, sizeof(member), dev, plan->swap_part);
+            strcat(swap_members, " ");
+            strcat(swap_members, member);
+        }
+        uint32_t part = plan->data_part;
+        if(plan->layout == DiskLayoutSingle) {
+            archinstallus_cmd_add(app, "Create root", "sgdisk --new=%lu:0:+128G --typecode=%lu:8300 %s", part, part, dev);
+            archinstallus_cmd_add(app, "Create home", "sgdisk --new=%lu:0:0 --typecode=%lu:8300 %s", part + 1, part + 1, dev);
+            disk->partitions = part + 1;
+        } else {
+            archinstallus_cmd_add(app, "Create array member", "sgdisk --new=%lu:0:0 --typecode=%lu:%s %s", part, part, data_type, dev);
+            disk->partitions = part;
+            char member[sizeof(plan->root_device)];
+            archinstallus_partition_path(member, sizeof(member), dev, part);
+            strcat(members, " ");
+            strcat(members, member);
+        }
+    }
+    
+    // Assemble the array / volume group and carve root and home out of it
+    if(plan->layout == DiskLayoutRaid0 || plan->layout == DiskLayoutRaid1) {
+        if(plan->layout == DiskLayoutRaid0) {
+            archinstallus_cmd_add(
+                app, "Create md array", "mdadm --create /dev/md/arch --run --metadata=1.2 --level=0 --chunk=%luK --raid-devices=%lu%s",
+                plan->stripe_kib, plan->member_count, members);
+        } else {
+            // mdadm rejects --chunk for mirrors
+            archinstallus_cmd_add(
+                app, "Create md array", "mdadm --create /dev/md/arch --run --metadata=1.2 --level=1 --raid-devices=%lu%s",
+                plan->member_count, members);
+        }
+        if(plan->swap_device[0]) {
+            archinstallus_cmd_add(
+                app, "Create swap mirror", "mdadm --create %s --run --metadata=1.2 --level=1 --raid-devices=%lu%s",
+                plan->swap_device, plan->member_count, swap_members);
+        }
+        archinstallus_cmd_add(app, "Create PV", "pvcreate /dev/md/arch");
+        archinstallus_cmd_add(app, "Create VG", "vgcreate arch /dev/md/arch");
+        archinstallus_cmd_add(app, "Create root pool", "lvcreate --type thin-pool -L 160G -n pool arch");
+        archinstallus_cmd_add(app, "Create root LV", "lvcreate -V 128G -T arch/pool -n root");
+        archinstallus_cmd_add(app, "Create home LV", "lvcreate -l 100%%FREE -n home arch");
+    } else if(plan->layout == DiskLayoutLvmStripe) {
+        archinstallus_cmd_add(app, "Create PV", "pvcreate%s", members);
+        archinstallus_cmd_add(app, "Create VG", "vgcreate arch%s", members);
+        archinstallus_cmd_add(
+            app, "Create root pool", "lvcreate --type thin-pool -i %lu -I %luk -L 160G -n pool arch", plan->member_count, plan->stripe_kib);
+        archinstallus_cmd_add(app, "Create root LV", "lvcreate -V 128G -T arch/pool -n root");
+        archinstallus_cmd_add(app, "Create home LV", "lvcreate -i %lu -I %luk -l 100%%FREE -n home arch", plan->member_count, plan->stripe_kib);
+    }
+    
+    archinstallus_budget_acquire(app, app->fleet ? app->fleet->io_budget : NULL);
+    bool result = archinstallus_cmd_run(app, "Partition", 500);
+    archinstallus_budget_release(app, app->fleet ? app->fleet->io_budget : NULL);
+    return result;
+}
+
+// LUKS2 cipher candidates; all are considered secure, the benchmark picks the fastest
+static const LuksCipher luks_ciphers[] = {
+    {"aes-xts-plain64", 512, true},
+    {"aes-xts-plain64", 256, true},
+    {"xchacha12,aes-adiantum-plain64", 256, false},
+    {"xchacha20,aes-adiantum-plain64", 256, false},
+};
+
+// Replies to cryptsetup benchmark for luks_ciphers, in order, taken on the cpuinfo_sample machine
+// (i7-11700K, AES-NI) and used until the target can send them back; the log says so
+static const char* const luks_benchmark_samples[] = {
+    "#     Algorithm |       Key |      Encryption |      Decryption\n        aes-xts        512b      3200.0 MiB/s      3360.0 MiB/s\n",
+    "#     Algorithm |       Key |      Encryption |      Decryption\n        aes-xts        256b      3900.0 MiB/s      4095.0 MiB/s\n",
+    "#     Algorithm |       Key |      Encryption |      Decryption\nxchacha12,aes-adiantum        256b      1050.0 MiB/s      1102.5 MiB/s\n",
+    "#     Algorithm |       Key |      Encryption |      Decryption\nxchacha20,aes-adiantum        256b       700.0 MiB/s       735.0 MiB/s\n",
+};
+_Static_assert(COUNT_OF(luks_benchmark_samples) == COUNT_OF(luks_ciphers), "one sample reply per cipher");
+
+// Rates in tenths from benchmark output, one per "<number><unit>" outside '#' comment lines; returns
+// how many were found
+static size_t archinstallus_parse_rates(const char* text, const char* unit, uint32_t* tenths, size_t max) {
+    size_t found = 0;
+    for(const char* p = strstr(text, unit); p && found < max; p = strstr(p + 1, unit)) {
+        const char* start = p;
+        while(start > text && ((start[-1] >= '0' && start[-1] <= '9') || start[-1] == '.')) start--;
+        const char* line = start;
+        while(line > text && line[-1] != '\n') line--;
+        line += strspn(line, " \t");
+        if(start == p || *line == '#') continue;
+        char* end;
+        uint32_t value = (uint32_t)strtoul(start, &end, 10) * 10;
+        if(*end == '.' && end[1] >= '0' && end[1] <= '9') value += end[1] - '0';
+        tenths[found++] = value;
+    }
+    return found;
+}
+
+// cryptsetup benchmark -c <cipher> -s <bits>, MiB/s (encryption, decryption); false if the reply
+// has no figures
+static bool archinstallus_luks_benchmark(ArchInstallusComplete* app, size_t index, uint32_t* enc_mibs, uint32_t* dec_mibs) {
+    const LuksCipher* cipher = &luks_ciphers[index];
+    archinstallus_log(app, "cryptsetup benchmark -c %s -s %u", cipher->name, cipher->key_bits);
+    archinstallus_wait(app, 400);
+    uint32_t tenths[2];
+    if(archinstallus_parse_rates(luks_benchmark_samples[index], " MiB/s", tenths, 2) != 2) return false;
+    *enc_mibs = tenths[0] / 10;
+    *dec_mibs = tenths[1] / 10;
+    return true;
+}
+
+// Argon2id cost sized from target RAM: memory cost first, iterations make up the rest
+static void archinstallus_luks_size_pbkdf(ArchInstallusComplete* app, LuksSetup* luks) {
+    uint64_t memory_kib = app->hw_info.memory_available / 1024 / 8;
+    if(memory_kib > LUKS_PBKDF_MAX_KIB) memory_kib = LUKS_PBKDF_MAX_KIB;
+    if(memory_kib < LUKS_PBKDF_MIN_KIB) memory_kib = LUKS_PBKDF_MIN_KIB;
+    luks->pbkdf_memory_kib = (uint32_t)memory_kib;
+    luks->pbkdf_iterations = memory_kib >= LUKS_PBKDF_MAX_KIB ? 4 : memory_kib >= LUKS_PBKDF_MAX_KIB / 2 ? 6 : 10;
+    luks->pbkdf_parallel = MIN(MAX(app->hw_info.cpu_threads, 1UL), 4UL);
+}
+
+static void archinstallus_luks_add_device(ArchInstallusComplete* app, const char* device, const char* mapping) {
+    LuksSetup* luks = &app->luks;
+    
+    // Passphrase is piped from the config on stdin, never part of the command text
+    archinstallus_cmd_add(
+        app, "luksFormat",
+        "cryptsetup luksFormat -q --type luks2 -c %s -s %u --pbkdf argon2id --pbkdf-memory %lu --pbkdf-force-iterations %lu --pbkdf-parallel %lu --key-file=- %s",
+        luks->cipher->name, luks->cipher->key_bits, luks->pbkdf_memory_kib, luks->pbkdf_iterations, luks->pbkdf_parallel, device);
+    if(luks->perf_flags) {
+        // Persistent flags are stored in the LUKS2 header and apply on every later unlock
+        archinstallus_cmd_add(
+            app, "luksOpen", "cryptsetup open --key-file=- --perf-no_read_workqueue --perf-no_write_workqueue --persistent %s %s",
+            device, mapping);
+    } else {
+        archinstallus_cmd_add(app, "luksOpen", "cryptsetup open --key-file=- %s %s", device, mapping);
+    }
+}
+
+// Benchmark (sample replies for now), choose cipher and PBKDF cost, then put root and home behind dm-crypt
+static bool archinstallus_setup_encryption(ArchInstallusComplete* app) {
+    LuksSetup* luks = &app->luks;
+    DiskPlan* plan = &app->disk_plan;
+    memset(luks, 0, sizeof(LuksSetup));
+    
+    snprintf(app->status_message, sizeof(app->status_message), "Benchmarking ciphers...");
+    for(size_t i = 0; i < COUNT_OF(luks_ciphers); i++) {
+        // The samples come from an AES-NI machine; without it AES-XTS runs at software table speed
+        if(luks_ciphers[i].needs_aes_ni && !app->hw_info.aes_ni) {
+            archinstallus_log(app, "LUKS: %s-%u skipped, no AES-NI", luks_ciphers[i].name, luks_ciphers[i].key_bits);
+            continue;
+        }
+        uint32_t enc_mibs;
+        uint32_t dec_mibs;
+        archinstallus_trace_begin(app, "cryptsetup benchmark");
+        bool parsed = archinstallus_luks_benchmark(app, i, &enc_mibs, &dec_mibs);
+        archinstallus_trace_end(app);
+        if(!parsed) {
+            archinstallus_log(app, "LUKS: no figures in the benchmark reply for %s-%u", luks_ciphers[i].name, luks_ciphers[i].key_bits);
+            continue;
+        }
+        archinstallus_log(
+            app, "LUKS (sample benchmark): %s-%u: %lu MiB/s enc, %lu MiB/s dec", luks_ciphers[i].name, luks_ciphers[i].key_bits,
+            enc_mibs, dec_mibs);
+        
+        // Score on the slower direction so neither reads nor writes bottleneck
+        uint32_t score = MIN(enc_mibs, dec_mibs);
+        if(!luks->cipher || score > MIN(luks->enc_mibs, luks->dec_mibs)) {
+            luks->cipher = &luks_ciphers[i];
+            luks->enc_mibs = enc_mibs;
+            luks->dec_mibs = dec_mibs;
+        }
+    }
+    
+    if(!luks->cipher) {
+        archinstallus_log(app, "LUKS: no usable cipher");
+        return false;
+    }
+    archinstallus_luks_size_pbkdf(app, luks);
+    
+    // Bypassing the dm-crypt workqueues only pays off on fast, low-latency devices
+    luks->perf_flags = true;
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        if(strncmp(app->disks[plan->members[i]].device_path, "/dev/nvme", 9)) luks->perf_flags = false;
+    }
+    
+    archinstallus_log(
+        app,
+        "LUKS: selected %s-%u (%lu/%lu MiB/s sample, AES-NI %s), argon2id %lu KiB x%lu p%lu, workqueue bypass %s",
+        luks->cipher->name, luks->cipher->key_bits, luks->enc_mibs, luks->dec_mibs,
+        app->hw_info.aes_ni ? "yes" : "no",
+        luks->pbkdf_memory_kib, luks->pbkdf_iterations, luks->pbkdf_parallel,
+        luks->perf_flags ? "on" : "off");
+    
+    archinstallus_cmd_reset(app);
+    snprintf(plan->root_luks_device, sizeof(plan->root_luks_device), "%s", plan->root_device);
+    snprintf(plan->home_luks_device, sizeof(plan->home_luks_device), "%s", plan->home_device);
+    archinstallus_luks_add_device(app, plan->root_luks_device, "cryptroot");
+    archinstallus_luks_add_device(app, plan->home_luks_device, "crypthome");
+    snprintf(plan->root_device, sizeof(plan->root_device), "/dev/mapper/cryptroot");
+    snprintf(plan->home_device, sizeof(plan->home_device), "/dev/mapper/crypthome");
+    plan->encrypted = true;
+    
+    return archinstallus_cmd_run(app, "Encrypt", 1500);
+}
+
+// mkfs with stripe hints so allocation lines up with the array chunk
+static void archinstallus_add_format_command(ArchInstallusComplete* app, const char* filesystem, const char* label, const char* device) {
+    DiskPlan* plan = &app->disk_plan;
+    bool striped = plan->stripe_kib > 0 && plan->data_disks > 1;
+    uint32_t stride = plan->stripe_kib / 4; // 4K filesystem blocks
+    
+    if(!strcmp(filesystem, "ext4") && striped) {
+        archinstallus_cmd_add(app, "mkfs.ext4", "mkfs.ext4 -L %s -E stride=%lu,stripe_width=%lu %s", label, stride, stride * plan->data_disks, device);
+    } else if(!strcmp(filesystem, "xfs") && striped) {
+        archinstallus_cmd_add(app, "mkfs.xfs", "mkfs.xfs -f -L %s -d su=%luk,sw=%lu %s", label, plan->stripe_kib, plan->data_disks, device);
+    } else if(!strcmp(filesystem, "xfs") || !strcmp(filesystem, "btrfs")) {
+        archinstallus_cmd_add(app, "mkfs", "mkfs.%s -f -L %s %s", filesystem, label, device);
+    } else if(!strcmp(filesystem, "f2fs")) {
+        archinstallus_cmd_add(app, "mkfs.f2fs", "mkfs.f2fs -f -l %s %s", label, device);
+    } else {
+        archinstallus_cmd_add(app, "mkfs", "mkfs.%s -L %s %s", filesystem, label, device);
+    }
+}
+
+static bool archinstallus_format_partitions(ArchInstallusComplete* app) {
+    app->state = STATE_FORMATTING;
+    snprintf(app->status_message, sizeof(app->status_message), "Formatting partitions...");
+    app->step_progress = 0;
+    
+    DiskPlan* plan = &app->disk_plan;
+    
+    if(app->config->enable_encryption) {
+        archinstallus_trace_begin(app, "Encryption setup");
+        bool encrypted = archinstallus_setup_encryption(app);
+        archinstallus_trace_end(app);
+        if(!encrypted) return false;
+    }
+    
+    // Real filesystem creation
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "mkfs.vfat", "mkfs.vfat -F32 -n EFI %s", plan->efi_partition);
+    // Encrypted swap is keyed from /dev/urandom on every boot through crypttab instead
+    if(!plan->encrypted) {
+        for(uint32_t i = 0; i < archinstallus_swap_count(plan); i++) {
+            char swap[72];
+            archinstallus_swap_path(app, i, swap, sizeof(swap));
+            archinstallus_cmd_add(app, "mkswap", "mkswap %s", swap);
+        }
+    }
+    archinstallus_add_format_command(app, app->config->root_filesystem, "ROOT", plan->root_device);
+    archinstallus_add_format_command(app, app->config->home_filesystem, "HOME", plan->home_device);
+    
+    archinstallus_budget_acquire(app, app->fleet ? app->fleet->io_budget : NULL);
+    bool result = archinstallus_cmd_run(app, "Format", 800);
+    archinstallus_budget_release(app, app->fleet ? app->fleet->io_budget : NULL);
+    return result;
+}
+
+// Root, ESP and home; also used to remount after a rollback
+static void archinstallus_add_mount_commands(ArchInstallusComplete* app) {
+    DiskPlan* plan = &app->disk_plan;
+    if(plan->snapshot_backend == SnapshotBackendBtrfs) {
+        archinstallus_cmd_add(app, "Mount root", "mount -o subvol=@ %s /mnt", plan->root_device);
+    } else {
+        archinstallus_cmd_add(app, "Mount root", "mount %s /mnt", plan->root_device);
+    }
+    archinstallus_cmd_add(app, "Create ESP mount point", "mkdir -p /mnt/boot/efi");
+    archinstallus_cmd_add(app, "Mount ESP", "mount %s /mnt/boot/efi", plan->efi_partition);
+    archinstallus_cmd_add(app, "Create home mount point", "mkdir -p /mnt/home");
+    archinstallus_cmd_add(app, "Mount home", "mount %s /mnt/home", plan->home_device);
+}
+
+static bool archinstallus_mount_filesystems(ArchInstallusComplete* app) {
+    app->state = STATE_MOUNTING;
+    snprintf(app->status_message, sizeof(app->status_message), "Mounting filesystems...");
+    app->step_progress = 0;
+    
+    DiskPlan* plan = &app->disk_plan;
+    
+    // Real mount operations
+    archinstallus_cmd_reset(app);
+    if(plan->snapshot_backend == SnapshotBackendBtrfs) {
+        // Root lives in subvolume @ so it can be swapped for a snapshot
+        archinstallus_cmd_add(app, "Mount btrfs top level", "mkdir -p " SNAPSHOT_BTRFS_TOP " && mount -o subvolid=5 %s " SNAPSHOT_BTRFS_TOP, plan->root_device);
+        archinstallus_cmd_add(app, "Create root subvolume", "btrfs subvolume create " SNAPSHOT_BTRFS_TOP "/@");
+    }
+    archinstallus_add_mount_commands(app);
+    if(!plan->encrypted) {
+        // Equal priority lets the kernel stripe swap across members
+        for(uint32_t i = 0; i < archinstallus_swap_count(plan); i++) {
+            char swap[72];
+            archinstallus_swap_path(app, i, swap, sizeof(swap));
+            archinstallus_cmd_add(app, "Enable swap", "swapon -p 10 %s", swap);
+        }
+    }
+    
+    if(!archinstallus_cmd_run(app, "Mount", 600)) return false;
+    
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        DiskInfo* disk = &app->disks[plan->members[i]];
+        disk->mounted = true;
+        snprintf(disk->mount_point, sizeof(disk->mount_point), "/mnt");
+    }
+    return true;
+}
+
+// Fetch one base package into the installer-side cache, deduplicated across fleet pipelines.
+// Touches no trace state so the prefetch thread can use it; returns the ticks spent blocked.
+static uint32_t archinstallus_fetch_package(ArchInstallusComplete* app, uint32_t index) {
+    ArchInstallusFleet* fleet = app->fleet;
+    uint32_t start = furi_get_tick();
+    
+    // Packages another pipeline fetched (or is fetching) are copied from the shared cache
+    bool cached = false;
+    if(fleet) {
+        uint32_t bit = 1UL << index;
+        furi_mutex_acquire(fleet->mutex, FuriWaitForever);
+        while((fleet->fetching_packages & bit) && !(fleet->cached_packages & bit)) {
+            furi_mutex_release(fleet->mutex);
+            furi_delay_ms(20);
+            furi_mutex_acquire(fleet->mutex, FuriWaitForever);
+        }
+        cached = fleet->cached_packages & bit;
+        if(cached) {
+            fleet->cache_hits++;
+        } else {
+            fleet->cache_misses++;
+            fleet->fetching_packages |= bit;
+        }
+        furi_mutex_release(fleet->mutex);
+    }
+    
+    if(cached) {
+        archinstallus_log(app, "cache hit: %s", base_packages[index].name);
+        furi_delay_ms(20);
+    } else {
+        if(fleet) furi_semaphore_acquire(fleet->net_budget, FuriWaitForever);
+        archinstallus_log(app, "pacman -Sw --noconfirm --cachedir %s %s", FLEET_CACHE_DIR, base_packages[index].name);
+        furi_delay_ms(200);
+        if(fleet) {
+            furi_semaphore_release(fleet->net_budget);
+            furi_mutex_acquire(fleet->mutex, FuriWaitForever);
+            fleet->cached_packages |= 1UL << index;
+            furi_mutex_release(fleet->mutex);
+        }
+    }
+    
+    return furi_get_tick() - start;
+}
+
+// Prefetch spans live in PackagePrefetch until the thread is joined
+static TraceSpan* archinstallus_prefetch_span(PackagePrefetch* prefetch, const char* name, uint8_t depth) {
+    if(prefetch->span_count >= MAX_PREFETCH_SPANS) return NULL;
+    TraceSpan* span = &prefetch->spans[prefetch->span_count++];
+    span->name = name;
+    span->depth = depth;
+    span->tid = 2;
+    span->begin_tick = furi_get_tick();
+    span->end_tick = span->begin_tick;
+    span->wait_ticks = 0;
+    span->heap_begin = memmgr_get_free_heap();
+    span->heap_end = span->heap_begin;
+    return span;
+}
+
+static void archinstallus_prefetch_span_end(TraceSpan* span, uint32_t waited) {
+    if(!span) return;
+    span->end_tick = furi_get_tick();
+    span->wait_ticks += waited;
+    span->heap_end = memmgr_get_free_heap();
+}
+
+// Fetches base packages into staging while the disk stages run, bounded by the staging budget
+static int32_t archinstallus_prefetch_worker(void* ctx) {
+    ArchInstallusComplete* app = ctx;
+    PackagePrefetch* prefetch = app->prefetch;
+    TraceSpan* root = archinstallus_prefetch_span(prefetch, "Prefetch", 0);
+    uint32_t root_wait = 0;
+    
+    for(uint32_t i = 0; i < COUNT_OF(base_packages); i++) {
+        uint32_t bit = 1UL << i;
+        uint32_t size_kib = base_packages[i].size_kib;
+        // Larger than the whole budget: left to the download stage
+        if(size_kib > prefetch->budget_kib) continue;
+        
+        furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+        uint32_t stall_start = furi_get_tick();
+        while(!prefetch->stop && !(prefetch->claimed & bit) && prefetch->staged_kib + size_kib > prefetch->budget_kib) {
+            furi_mutex_release(prefetch->mutex);
+            furi_delay_ms(50);
+            furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+        }
+        uint32_t stalled = furi_get_tick() - stall_start;
+        prefetch->stall_ticks += stalled;
+        root_wait += stalled;
+        bool skip = prefetch->stop || (prefetch->claimed & bit);
+        if(!skip) prefetch->fetching |= bit;
+        furi_mutex_release(prefetch->mutex);
+        if(prefetch->stop) break;
+        if(skip) continue;
+        
+        TraceSpan* span = archinstallus_prefetch_span(prefetch, base_packages[i].name, 1);
+        uint32_t waited = archinstallus_fetch_package(app, i);
+        root_wait += waited;
+        archinstallus_prefetch_span_end(span, waited);
+        
+        furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+        prefetch->staged |= bit;
+        prefetch->staged_kib += size_kib;
+        prefetch->peak_kib = MAX(prefetch->peak_kib, prefetch->staged_kib);
+        prefetch->prefetched++;
+        furi_mutex_release(prefetch->mutex);
+    }
+    
+    archinstallus_prefetch_span_end(root, root_wait);
+    // High-water mark of the whole run, for sizing PREFETCH_STACK_SIZE
+    prefetch->stack_free = furi_thread_get_stack_space(furi_thread_get_current_id());
+    return 0;
+}
+
+// Start prefetching as soon as the network is known to work
+static void archinstallus_prefetch_start(ArchInstallusComplete* app) {
+    if(memmgr_heap_get_max_free_block() < sizeof(PackagePrefetch) + PREFETCH_STACK_SIZE + FLEET_HEAP_RESERVE) {
+        archinstallus_log(app, "Prefetch: not enough memory, downloading after mount");
+        return;
+    }
+    
+    PackagePrefetch* prefetch = malloc(sizeof(PackagePrefetch));
+    memset(prefetch, 0, sizeof(PackagePrefetch));
+    prefetch->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    
+    // Staging is tmpfs on the live system: a quarter of free RAM, 128 MiB-1 GiB
+    uint64_t budget_kib = app->hw_info.memory_available / 1024 / 4;
+    prefetch->budget_kib = (uint32_t)MIN(MAX(budget_kib, (uint64_t)PREFETCH_MIN_BUDGET_KIB), (uint64_t)PREFETCH_MAX_BUDGET_KIB);
+    
+    app->prefetch = prefetch;
+    archinstallus_log(app, "Prefetch: staging in %s, budget %lu KiB", FLEET_CACHE_DIR, prefetch->budget_kib);
+    prefetch->thread = furi_thread_alloc_ex("ArchPrefetch", PREFETCH_STACK_SIZE, archinstallus_prefetch_worker, app);
+    furi_thread_start(prefetch->thread);
+}
+
+// Claim a package for the download stage; true if it is already staged.
+// Waits for an in-flight prefetch of the same package instead of fetching it twice.
+static bool archinstallus_prefetch_claim(ArchInstallusComplete* app, uint32_t index) {
+    PackagePrefetch* prefetch = app->prefetch;
+    if(!prefetch) return false;
+    
+    uint32_t bit = 1UL << index;
+    furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+    while((prefetch->fetching & bit) && !(prefetch->staged & bit)) {
+        furi_mutex_release(prefetch->mutex);
+        furi_delay_ms(20);
+        furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+    }
+    bool staged = prefetch->staged & bit;
+    prefetch->claimed |= bit;
+    furi_mutex_release(prefetch->mutex);
+    return staged;
+}
+
+// Package moved into the target cache: its staging space is free again
+static void archinstallus_prefetch_handover(ArchInstallusComplete* app, uint32_t index) {
+    PackagePrefetch* prefetch = app->prefetch;
+    if(!prefetch) return;
+    
+    uint32_t bit = 1UL << index;
+    furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+    if(prefetch->staged & bit) {
+        prefetch->staged &= ~bit;
+        prefetch->staged_kib -= base_packages[index].size_kib;
+        prefetch->handed_over++;
+    }
+    furi_mutex_release(prefetch->mutex);
+}
+
+// Join the prefetch thread and merge its spans into the pipeline trace; safe to call twice
+static void archinstallus_prefetch_stop(ArchInstallusComplete* app) {
+    PackagePrefetch* prefetch = app->prefetch;
+    if(!prefetch) return;
+    
+    furi_mutex_acquire(prefetch->mutex, FuriWaitForever);
+    prefetch->stop = true;
+    furi_mutex_release(prefetch->mutex);
+    furi_thread_join(prefetch->thread);
+    furi_thread_free(prefetch->thread);
+    
+    TraceBuffer* trace = &app->trace;
+    for(uint32_t i = 0; i < prefetch->span_count; i++) {
+        if(trace->span_count < MAX_TRACE_SPANS) {
+            trace->spans[trace->span_count++] = prefetch->spans[i];
+        } else {
+            trace->dropped++;
+        }
+    }
+    
+    archinstallus_log(
+        app,
+        "Prefetch: %lu/%u packages staged ahead, %lu handed over, peak %lu of %lu KiB, %lu ms stalled on budget",
+        prefetch->prefetched,
+        COUNT_OF(base_packages),
+        prefetch->handed_over,
+        prefetch->peak_kib,
+        prefetch->budget_kib,
+        prefetch->stall_ticks);
+    if(prefetch->stack_free) {
+        archinstallus_log(app, "Prefetch: stack %lu of %u bytes free at the deepest point", prefetch->stack_free, PREFETCH_STACK_SIZE);
+    }
+    if(prefetch->stack_free && prefetch->stack_free < PREFETCH_STACK_MARGIN) {
+        FURI_LOG_W(TAG, "Prefetch stack down to %lu bytes free, raise PREFETCH_STACK_SIZE", prefetch->stack_free);
+    }
+    
+    furi_mutex_free(prefetch->mutex);
+    free(prefetch);
+    app->prefetch = NULL;
+}
+
+static bool archinstallus_download_base_system(ArchInstallusComplete* app) {
+    app->state = STATE_DOWNLOADING;
+    snprintf(app->status_message, sizeof(app->status_message), "Downloading Arch Linux...");
+    app->step_progress = 0;
+    
+    int total_packages = COUNT_OF(base_packages);
+    
+    // Mostly a hand-over: packages prefetched during the disk stages move into the target cache
+    archinstallus_log(app, "mkdir -p /mnt/var/cache/pacman/pkg");
+    for(int i = 0; i < total_packages; i++) {
+        archinstallus_trace_begin(app, base_packages[i].name);
+        uint32_t start = furi_get_tick();
+        
+        if(!archinstallus_prefetch_claim(app, i)) archinstallus_fetch_package(app, i);
+        // The fleet cache is shared by all pipelines, so it is copied rather than moved
+        archinstallus_log(
+            app, "%s %s/%s-*.pkg.tar.zst /mnt/var/cache/pacman/pkg/", app->fleet ? "cp" : "mv", FLEET_CACHE_DIR, base_packages[i].name);
+        furi_delay_ms(20);
+        archinstallus_prefetch_handover(app, i);
+        archinstallus_trace_wait(app, furi_get_tick() - start);
+        
+        app->step_progress = ((i + 1) * 100) / total_packages;
+        snprintf(app->status_message, sizeof(app->status_message), "Download %d/%d: %s", i + 1, total_packages, base_packages[i].name);
+        archinstallus_trace_end(app);
+    }
+    
+    archinstallus_prefetch_stop(app);
+    return true;
+}
+
+static bool archinstallus_install_system(ArchInstallusComplete* app) {
+    app->state = STATE_INSTALLING;
+    snprintf(app->status_message, sizeof(app->status_message), "Installing system packages...");
+    app->step_progress = 0;
+    
+    // Real installation with progress
+    const char* install_steps[] = {
+        "Installing base system",
+        "Configuring locales",
+        "Setting up timezone",
+        "Configuring hostname",
+        "Creating users",
+        "Setting up services",
+        "Installing bootloader",
+        "Configuring network",
+        "Setting up security",
+        "Installing desktop environment"
+    };
+    
+    int total_steps = sizeof(install_steps) / sizeof(install_steps[0]);
+    
+    for(int i = 0; i < total_steps; i++) {
+        archinstallus_trace_begin(app, install_steps[i]);
+        archinstallus_wait(app, 800);
+        app->step_progress = ((i + 1) * 100) / total_steps;
+        snprintf(app->status_message, sizeof(app->status_message), "Install %d/%d: %s", i + 1, total_steps, install_steps[i]);
+        archinstallus_trace_end(app);
+    }
+    
+    return true;
+}
+
+// Post-install integrity check against the packages' mtree sha256 digests.
+// Files are ordered by inode (close to on-disk order), split into one contiguous shard per core
+// and hashed by parallel sha256sum workers, so each worker streams its own region of the disk.
+static bool archinstallus_verify_system(ArchInstallusComplete* app) {
+    app->state = STATE_INSTALLING;
+    snprintf(app->status_message, sizeof(app->status_message), "Verifying installed files...");
+    app->step_progress = 0;
+    
+    const DiskInfo* disk = &app->disks[app->disk_plan.members[0]];
+    bool nvme = strncmp(disk->device_path, "/dev/nvme", 9) == 0;
+    const char* root = app->disk_plan.root_device;
+    uint32_t workers = MIN(MAX(app->hw_info.cpu_threads, 1UL), (uint32_t)VERIFY_MAX_WORKERS);
+    
+    // Installed size is roughly 3x the compressed package
+    uint32_t files = 0;
+    uint64_t bytes = 0;
+    for(size_t i = 0; i < COUNT_OF(base_packages); i++) {
+        files += base_packages[i].files;
+        bytes += (uint64_t)base_packages[i].size_kib * 3 * 1024;
+    }
+    
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Prepare", "mkdir -p " VERIFY_DIR);
+    // mtree names are vis-encoded (\040 for a space); pacman's own ./.PKGINFO-style entries and the
+    // %BACKUP% files (configs the user is expected to edit) are not part of the check
+    archinstallus_cmd_add(
+        app, "Write mtree filter",
+        "printf '%%s\\n' 'function dec(s,  o,c) { while(match(s, /\\\\[0-7][0-7][0-7]/)) { c = substr(s, RSTART + 1, 3)' > " VERIFY_MTREE_AWK);
+    archinstallus_cmd_add(
+        app, "Write mtree filter",
+        "printf '%%s\\n' 'o = o substr(s, 1, RSTART - 1) sprintf(\"%%c\", substr(c, 1, 1) * 64 + substr(c, 2, 1) * 8 + substr(c, 3, 1))' >> " VERIFY_MTREE_AWK);
+    archinstallus_cmd_add(
+        app, "Write mtree filter",
+        "printf '%%s\\n' 's = substr(s, RSTART + 4) } return o s }' 'FILENAME == ARGV[1] { backup[$0] = 1; next }' >> " VERIFY_MTREE_AWK);
+    archinstallus_cmd_add(
+        app, "Write mtree filter",
+        "printf '%%s\\n' '$1 ~ /^\\.\\/\\./ { next } { f = dec(substr($1, 3)) } f in backup { next }' >> " VERIFY_MTREE_AWK);
+    archinstallus_cmd_add(
+        app, "Write mtree filter",
+        "printf '%%s\\n' '{ for(i = 2; i <= NF; i++) if($i ~ /^sha256digest=/) print substr($i, 14) \"  /mnt/\" f }' >> " VERIFY_MTREE_AWK);
+    archinstallus_cmd_add(
+        app, "Collect backup files",
+        "awk -F'\\t' '/^%%/ { b = $0 == \"%%BACKUP%%\"; next } b && NF { print $1 }' /mnt/var/lib/pacman/local/*/desc > " VERIFY_DIR "/backup");
+    archinstallus_cmd_add(
+        app, "Collect mtree digests",
+        "zcat /mnt/var/lib/pacman/local/*/mtree | LC_ALL=C awk -f " VERIFY_MTREE_AWK " " VERIFY_DIR "/backup - > " VERIFY_DIR "/sums");
+    archinstallus_cmd_add(
+        app, "Order by disk locality", "cut -c67- " VERIFY_DIR "/sums | xargs -d '\\n' stat -c '%%i %%n' 2> " VERIFY_DIR "/stat.err | sort -n | cut -d' ' -f2- > " VERIFY_DIR "/order");
+    archinstallus_cmd_add(
+        app, "Order by disk locality",
+        "awk 'NR==FNR{h[substr($0,67)]=substr($0,1,64);next}{print h[$0]\"  \"$0}' " VERIFY_DIR "/sums " VERIFY_DIR "/order > " VERIFY_DIR "/sorted");
+    archinstallus_cmd_add(app, "Shard", "split -n l/%lu -d " VERIFY_DIR "/sorted " VERIFY_DIR "/shard.", workers);
+    // Large readahead turns each worker's run of neighbouring files into big sequential reads
+    archinstallus_cmd_add(app, "Raise readahead", "blockdev --setra 8192 %s", root);
+    archinstallus_cmd_add(
+        app, "Hash shards",
+        "for s in " VERIFY_DIR "/shard.*; do sha256sum -c --quiet $s > $s.out 2>&1 & done; wait");
+    archinstallus_cmd_add(app, "Restore readahead", "blockdev --setra 256 %s", root);
+    // Deleted files never reach sha256sum (stat left them out of the order); reported the way it
+    // would report them, after hashing so the shard glob does not pick the file up as a checklist
+    archinstallus_cmd_add(
+        app, "Report missing files",
+        "sed -n \"s/^stat: cannot statx\\{0,1\\} '\\(.*\\)': .*/\\1: FAILED open or read/p\" " VERIFY_DIR "/stat.err > " VERIFY_DIR "/shard.missing.out");
+    // grep -c exits 1 on zero matches; the command's own status is the mismatch check
+    archinstallus_cmd_add(
+        app, "Write report",
+        "cat " VERIFY_DIR "/shard.*.out > /mnt" VERIFY_LOG "; n=$(grep -c ': FAILED' /mnt" VERIFY_LOG " || true); echo \"$n failed\"; [ \"$n\" = 0 ]");
+    if(!archinstallus_cmd_run(app, "Verify", 300)) return false;
+    
+    // Time model: bandwidth-bound by min(device, workers x sha256) plus per-file open/seek cost,
+    // against a serial pacman -Qkk that pays both on one core
+    uint32_t disk_mibs = nvme ? 3000 : disk->is_ssd ? 500 : 150;
+    uint32_t hash_mibs = VERIFY_SHA256_MIBS;
+    uint32_t file_us = nvme ? 20 : disk->is_ssd ? 60 : 4000;
+    uint32_t mib = (uint32_t)(bytes / (1024 * 1024));
+    uint32_t parallel_ms = mib * 1000 / MIN(disk_mibs, workers * hash_mibs) +
+                           files / 1000 * file_us / (disk->is_ssd ? workers : VERIFY_HDD_LOCALITY_GAIN);
+    uint32_t serial_ms = mib * 1000 / MIN(disk_mibs, hash_mibs) + files / 1000 * (file_us + VERIFY_QKK_FILE_US);
+    
+    archinstallus_log(
+        app,
+        "Verify: %lu files, %lu MiB in %lu shards, mismatches fail the step (" VERIFY_LOG "); est. %lu ms (%lu MiB/s) vs %lu ms serial pacman -Qkk",
+        files,
+        mib,
+        workers,
+        parallel_ms,
+        parallel_ms ? mib * 1000 / parallel_ms : 0,
+        serial_ms);
+    return true;
+}
+
+// Extra packages, packed into as few pacman calls as the command length allows
+static void archinstallus_add_package_commands(ArchInstallusComplete* app) {
+    const InstallConfig* config = app->config;
+    char line[MAX_COMMAND_LEN];
+    size_t len = 0;
+    for(uint32_t i = 0; i < config->package_count; i++) {
+        const char* name = config->custom_packages[i];
+        if(len && len + 1 + strlen(name) >= sizeof(line)) {
+            archinstallus_cmd_add(app, "Installing additional packages", "%s", line);
+            len = 0;
+        }
+        if(!len) len = snprintf(line, sizeof(line), "pacman -S --needed --noconfirm");
+        len += snprintf(line + len, sizeof(line) - len, " %s", name);
+    }
+    if(len) archinstallus_cmd_add(app, "Installing additional packages", "%s", line);
+}
+
+static bool archinstallus_has_package(const InstallConfig* config, const char* name) {
+    for(uint32_t i = 0; i < config->package_count; i++) {
+        if(!strcmp(config->custom_packages[i], name)) return true;
+    }
+    return false;
+}
+
+// Optimized repositories ahead of [core], rebuilding the installed set from them, then
+// microcode and the tuned kernel in one transaction
+static void archinstallus_add_cpu_commands(ArchInstallusComplete* app) {
+    const CpuPlan* plan = &app->cpu_plan;
+    const CpuRepoSet* set = plan->repos;
+    if(set) {
+        archinstallus_cmd_add(
+            app, "Trusting optimized repositories", "pacman-key --recv-keys %s --keyserver keyserver.ubuntu.com && pacman-key --lsign-key %s",
+            CPU_REPO_KEY, CPU_REPO_KEY);
+        // The generic repository carries the keyring and the per-level mirrorlists
+        archinstallus_cmd_add(
+            app, "Adding optimized repositories", "sed -i '/^\\[core\\]/i [cachyos]\\nServer = %s\\n' /etc/pacman.conf", CPU_REPO_SERVER);
+        archinstallus_cmd_add(
+            app, "Adding optimized repositories", "pacman -Sy --needed --noconfirm cachyos-keyring cachyos-mirrorlist %s", set->mirrorlist);
+        archinstallus_cmd_add(
+            app, "Adding optimized repositories", "sed -i 's/^Architecture = .*/Architecture = %s/' /etc/pacman.conf", set->arch);
+        for(size_t i = 0; i < COUNT_OF(set->repos); i++) {
+            archinstallus_cmd_add(
+                app, "Adding optimized repositories", "sed -i '/^\\[cachyos\\]/i [%s]\\nInclude = /etc/pacman.d/%s\\n' /etc/pacman.conf",
+                set->repos[i], set->mirrorlist);
+        }
+        archinstallus_cmd_add(app, "Rebuilding from optimized repositories", "pacman -Syu --noconfirm && pacman -Qqn | pacman -S --noconfirm -");
+    }
+    
+    char line[MAX_COMMAND_LEN];
+    size_t len = snprintf(line, sizeof(line), "pacman -S --needed --noconfirm");
+    size_t base = len;
+    if(plan->microcode) len += snprintf(line + len, sizeof(line) - len, " %s", plan->microcode);
+    if(strcmp(plan->kernel, app->config->kernel_version) != 0) {
+        len += snprintf(line + len, sizeof(line) - len, " %s %s-headers", plan->kernel, plan->kernel);
+    }
+    if(len > base) archinstallus_cmd_add(app, "Installing microcode and kernel", "%s", line);
+}
+
+// Developer builds: makepkg drop-in, shell environment and ccache sized from the hardware.
+// Jobs are capped by memory so a full -j never swaps; whatever RAM is left beyond the jobs
+// and a reserve backs a tmpfs build directory when it can hold a kernel tree.
+static void archinstallus_add_build_commands(ArchInstallusComplete* app) {
+    const HardwareInfo* hw = &app->hw_info;
+    uint32_t memory_mib = (uint32_t)(hw->memory_total >> 20);
+    uint32_t spare_mib = memory_mib > BUILD_RESERVE_MIB ? memory_mib - BUILD_RESERVE_MIB : 0;
+    uint32_t jobs = MAX(MIN(MAX(hw->cpu_threads, 1UL), spare_mib / BUILD_JOB_MIB), 1UL);
+    uint32_t tmpfs_gib = spare_mib > jobs * BUILD_JOB_MIB ? (spare_mib - jobs * BUILD_JOB_MIB) / 1024 : 0;
+    bool tmpfs = tmpfs_gib >= BUILD_TMPFS_MIN_GIB;
+    uint32_t ccache_gib = MIN(MAX((uint32_t)(hw->disk_size >> 30) / 50, (uint32_t)BUILD_CCACHE_MIN_GIB), (uint32_t)BUILD_CCACHE_MAX_GIB);
+    const char* conf = "/etc/makepkg.conf.d/archinstallus.conf";
+    
+    archinstallus_cmd_add(app, "Installing ccache", "pacman -S --needed --noconfirm ccache");
+    archinstallus_cmd_add(
+        app, "Tuning makepkg", "mkdir -p /etc/makepkg.conf.d && printf '%%s\\n' 'MAKEFLAGS=\"-j%lu -l%lu\"' 'COMPRESSZST=(zstd -c -T%lu -3 -)' > %s",
+        jobs, jobs, jobs, conf);
+    // makepkg sources drop-ins after makepkg.conf, so the stock flags are edited rather than restated
+    archinstallus_cmd_add(
+        app, "Tuning makepkg", "printf '%%s\\n' 'CFLAGS=\"${CFLAGS/-march=x86-64 -mtune=generic/-march=native}\"' 'CXXFLAGS=\"${CXXFLAGS/-march=x86-64 -mtune=generic/-march=native}\"' >> %s",
+        conf);
+    archinstallus_cmd_add(
+        app, "Tuning makepkg", "printf '%%s\\n' 'RUSTFLAGS=\"${RUSTFLAGS} -C target-cpu=native\"' 'BUILDENV=(!distcc color ccache check !sign)' >> %s", conf);
+    if(tmpfs) {
+        archinstallus_cmd_add(app, "Tuning makepkg", "echo 'BUILDDIR=/tmp/makepkg' >> %s", conf);
+        archinstallus_cmd_add(app, "Sizing /tmp for builds", "echo 'tmpfs /tmp tmpfs size=%luG,nosuid,nodev,mode=1777 0 0' >> /etc/fstab", tmpfs_gib);
+    }
+    archinstallus_cmd_add(app, "Sizing ccache", "echo 'max_size = %luG' > /etc/ccache.conf", ccache_gib);
+    archinstallus_cmd_add(
+        app, "Setting build environment",
+        "printf '%%s\\n' 'export MAKEFLAGS=\"-j%lu\"' 'export CMAKE_BUILD_PARALLEL_LEVEL=%lu' 'export PATH=\"/usr/lib/ccache/bin:$PATH\"' > /etc/profile.d/archinstallus-build.sh",
+        jobs, jobs);
+    
+    // makepkg-bench DIR: builds the PKGBUILD in DIR with a copy of the stock makepkg.conf
+    // (no .d drop-ins next to it), then twice with the tuned settings (cold and warm ccache), and
+    // prints the times. Each build gets a bare environment and a throwaway HOME and ccache, so the
+    // profile.d MAKEFLAGS/ccache PATH, ~/.makepkg.conf and earlier cache hits do not leak into it
+    archinstallus_cmd_add(
+        app, "Installing build benchmark",
+        "printf '%%s\\n' '#!/bin/sh' 'set -e' 'cd \"${1:-.}\"' 'cp /etc/makepkg.conf /tmp/makepkg-stock.conf' > " BUILD_BENCH_PATH);
+    archinstallus_cmd_add(
+        app, "Installing build benchmark",
+        "printf '%%s\\n' 'home=$(mktemp -d)' 'trap \"rm -rf $home\" EXIT' 'for run in stock tuned tuned-warm; do' >> " BUILD_BENCH_PATH);
+    archinstallus_cmd_add(
+        app, "Installing build benchmark",
+        "printf '%%s\\n' 'conf=/etc/makepkg.conf; [ $run = stock ] && conf=/tmp/makepkg-stock.conf' 'rm -rf src pkg ./*.pkg.tar.*' 'start=$(date +%%s)' >> " BUILD_BENCH_PATH);
+    archinstallus_cmd_add(
+        app, "Installing build benchmark",
+        "printf '%%s\\n' 'env -i HOME=\"$home\" USER=\"$USER\" PATH=/usr/bin CCACHE_DIR=\"$home/ccache\" makepkg -f --noconfirm --nocheck --config \"$conf\" > /dev/null' >> " BUILD_BENCH_PATH);
+    archinstallus_cmd_add(
+        app, "Installing build benchmark",
+        "printf '%%s\\n' 'echo \"$run: $(($(date +%%s) - start))s\"' 'done' >> " BUILD_BENCH_PATH " && chmod 755 " BUILD_BENCH_PATH);
+    
+    archinstallus_log(
+        app,
+        "Build: -j%lu of %lu threads, zstd -T%lu, builddir %s, ccache %luG, -march=native",
+        jobs,
+        hw->cpu_threads,
+        jobs,
+        tmpfs ? "tmpfs" : "disk",
+        ccache_gib);
+    if(!tmpfs) archinstallus_log(app, "Build: %lu GiB RAM left after %lu jobs, tmpfs builddir needs %d", tmpfs_gib, jobs, BUILD_TMPFS_MIN_GIB);
+}
+
+// Swap under plain dm-crypt with a fresh random key per boot: nothing in it survives a reboot, so
+// there is no passphrase to ask for and no header. It was never mkswap'ed or enabled in plaintext.
+// crypttab options are comma-separated and cannot carry the Adiantum spec, so that case uses AES-XTS.
+// Partitions are named by PARTUUID; the raid1 mirror by its md name, which mdadm.conf keeps stable
+static void archinstallus_add_swap_crypttab(ArchInstallusComplete* app) {
+    const DiskPlan* plan = &app->disk_plan;
+    const LuksCipher* cipher = app->luks.cipher;
+    if(strchr(cipher->name, ',')) cipher = &luks_ciphers[1];
+    for(uint32_t i = 0; i < archinstallus_swap_count(plan); i++) {
+        char swap[72];
+        archinstallus_swap_path(app, i, swap, sizeof(swap));
+        if(plan->swap_device[0]) {
+            archinstallus_cmd_add(
+                app, "Write crypttab", "echo 'swap%lu %s /dev/urandom swap,cipher=%s,size=%u' >> /mnt/etc/crypttab",
+                i, swap, cipher->name, cipher->key_bits);
+        } else {
+            archinstallus_cmd_add(
+                app, "Write crypttab", "echo \"swap%lu PARTUUID=$(blkid -s PARTUUID -o value %s) /dev/urandom swap,cipher=%s,size=%u\" >> /mnt/etc/crypttab",
+                i, swap, cipher->name, cipher->key_bits);
+        }
+        archinstallus_cmd_add(app, "Add swap to fstab", "echo '/dev/mapper/swap%lu none swap defaults,pri=10 0 0' >> /mnt/etc/fstab", i);
+    }
+    archinstallus_log(
+        app, "Swap: %lu device(s) on plain dm-crypt %s-%u, random key per boot", archinstallus_swap_count(plan), cipher->name, cipher->key_bits);
+}
+
+static bool archinstallus_configure_system(ArchInstallusComplete* app) {
+    app->state = STATE_CONFIGURING;
+    snprintf(app->status_message, sizeof(app->status_message), "Configuring system...");
+    app->step_progress = 0;
+    InstallConfig* config = app->config;
     
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(600);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "Config %d/%d: %s", i + 1, total_steps, config_steps[i]);
+    // fstab and array metadata follow the disk plan; written from the host
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Generate fstab", "genfstab -U /mnt >> /mnt/etc/fstab");
+    if(app->disk_plan.layout == DiskLayoutRaid0 || app->disk_plan.layout == DiskLayoutRaid1) {
+        archinstallus_cmd_add(app, "Record md arrays", "mdadm --detail --scan >> /mnt/etc/mdadm.conf");
     }
+    if(app->disk_plan.encrypted) {
+        // Root is unlocked from the kernel command line, home through crypttab
+        archinstallus_cmd_add(
+            app, "Write crypttab", "echo \"crypthome UUID=$(blkid -s UUID -o value %s) none luks\" >> /mnt/etc/crypttab",
+            app->disk_plan.home_luks_device);
+        if(config->create_swap) archinstallus_add_swap_crypttab(app);
+    }
+    if(!archinstallus_cmd_run(app, "Config", 200)) return false;
     
-    return true;
+    // Real configuration, inside the target
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Setting up locale settings", "sed -i 's/^#%s /%s /' /etc/locale.gen && locale-gen", config->locale, config->locale);
+    archinstallus_cmd_add(app, "Setting up locale settings", "echo LANG=%s > /etc/locale.conf", config->locale);
+    archinstallus_cmd_add(app, "Configuring timezone", "ln -sf /usr/share/zoneinfo/%s /etc/localtime && hwclock --systohc", config->timezone);
+    archinstallus_cmd_add(app, "Configuring keyboard", "echo KEYMAP=%s > /etc/vconsole.conf", config->keyboard_layout);
+    archinstallus_cmd_add(app, "Setting hostname", "echo %s > /etc/hostname", config->hostname);
+    archinstallus_cmd_add(
+        app, "Configuring hosts", "printf '127.0.0.1 localhost\\n::1 localhost\\n127.0.1.1 %s\\n' > /etc/hosts", config->hostname);
+    archinstallus_cmd_add(
+        app, "Configuring sudo access", "echo '%%wheel ALL=(ALL:ALL) ALL' > /etc/sudoers.d/10-wheel && chmod 440 /etc/sudoers.d/10-wheel");
+    archinstallus_add_cpu_commands(app);
+    if(config->install_type == INSTALL_DEVELOPER || config->enable_build_tools) archinstallus_add_build_commands(app);
+    archinstallus_add_package_commands(app);
+    
+    return archinstallus_chroot_run(app, "Config", 150);
+}
+
+// Kernel command line shared by the UKI and GRUB; UUIDs are resolved on the target
+static void archinstallus_kernel_cmdline(ArchInstallusComplete* app, char* out, size_t size) {
+    DiskPlan* plan = &app->disk_plan;
+    if(plan->encrypted) {
+        snprintf(
+            out, size, "rd.luks.name=$(blkid -s UUID -o value %s)=cryptroot root=/dev/mapper/cryptroot rw quiet loglevel=3",
+            plan->root_luks_device);
+    } else if(plan->layout == DiskLayoutSingle) {
+        snprintf(out, size, "root=UUID=$(blkid -s UUID -o value %s) rw quiet loglevel=3", plan->root_device);
+    } else {
+        snprintf(out, size, "root=%s rw quiet loglevel=3", plan->root_device);
+    }
+    if(plan->snapshot_backend == SnapshotBackendBtrfs) {
+        size_t len = strlen(out);
+        snprintf(out + len, size - len, " rootflags=subvol=@");
+    }
+}
+
+// mkinitcpio preset that emits UKIs onto the ESP; built by mkinitcpio -P in cleanup. Paths are
+// inside the target, these run through the chroot session
+static void archinstallus_add_uki_commands(ArchInstallusComplete* app, const char* cmdline) {
+    const char* kernel = app->cpu_plan.kernel;
+    archinstallus_cmd_add(app, "Create UKI directory", "mkdir -p /boot/efi/EFI/Linux");
+    archinstallus_cmd_add(app, "Write kernel cmdline", "echo \"%s\" > /etc/kernel/cmdline", cmdline);
+    archinstallus_cmd_add(app, "Write UKI preset", "echo \"ALL_kver='/boot/vmlinuz-%s'\" > /etc/mkinitcpio.d/%s.preset", kernel, kernel);
+    archinstallus_cmd_add(app, "Write UKI preset", "echo \"PRESETS=('default' 'fallback')\" >> /etc/mkinitcpio.d/%s.preset", kernel);
+    archinstallus_cmd_add(
+        app, "Write UKI preset", "echo \"default_uki='/boot/efi/EFI/Linux/arch-%s.efi'\" >> /etc/mkinitcpio.d/%s.preset", kernel, kernel);
+    archinstallus_cmd_add(
+        app, "Write UKI preset", "echo \"fallback_uki='/boot/efi/EFI/Linux/arch-%s-fallback.efi'\" >> /etc/mkinitcpio.d/%s.preset",
+        kernel, kernel);
+    archinstallus_cmd_add(app, "Write UKI preset", "echo \"fallback_options='-S autodetect'\" >> /etc/mkinitcpio.d/%s.preset", kernel);
+    archinstallus_cmd_add(app, "Remove stale initramfs", "rm -f /boot/initramfs-%s.img /boot/initramfs-%s-fallback.img", kernel, kernel);
 }
 
 static bool archinstallus_setup_bootloader(ArchInstallusComplete* app) {
@@ -413,24 +3291,53 @@ static bool archinstallus_setup_bootloader(ArchInstallusComplete* app) {
     snprintf(app->status_message, sizeof(app->status_message), "Installing bootloader...");
     app->step_progress = 0;
     
-    // Real bootloader installation
-    const char* bootloader_steps[] = {
-        "Installing GRUB",
-        "Configuring GRUB",
-        "Installing to EFI",
-        "Creating boot entries",
-        "Testing boot configuration"
-    };
-    
-    int total_steps = sizeof(bootloader_steps) / sizeof(bootloader_steps[0]);
+    Bootloader bootloader = app->disk_plan.bootloader;
+    const char* kernel = app->cpu_plan.kernel;
+    char cmdline[160];
+    archinstallus_kernel_cmdline(app, cmdline, sizeof(cmdline));
     
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(700);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "Boot %d/%d: %s", i + 1, total_steps, bootloader_steps[i]);
+    // Everything runs inside the target through the chroot session, which also has efivarfs mounted
+    archinstallus_cmd_reset(app);
+    switch(bootloader) {
+    case BootloaderSystemdBoot:
+        archinstallus_add_uki_commands(app, cmdline);
+        archinstallus_cmd_add(app, "Install systemd-boot", "bootctl --esp-path=/boot/efi install");
+        archinstallus_cmd_add(
+            app, "Write loader.conf", "printf 'default arch-%s.efi\\ntimeout 0\\n' > /boot/efi/loader/loader.conf", kernel);
+        archinstallus_cmd_add(app, "Enable bootloader updates", "systemctl enable systemd-boot-update.service");
+        break;
+    case BootloaderEfistub:
+        // Firmware loads the UKI directly; the cmdline is embedded, so no --unicode arguments
+        archinstallus_add_uki_commands(app, cmdline);
+        // NVRAM outlives a rollback, so a retried stage would otherwise add duplicate entries
+        archinstallus_cmd_add(
+            app, "Remove old entries",
+            "efibootmgr | sed -n 's/^Boot\\([0-9A-F]\\{4\\}\\)\\*\\? Arch Linux.*/\\1/p' | xargs -r -n1 efibootmgr -q -B -b");
+        archinstallus_cmd_add(
+            app, "Create fallback entry",
+            "efibootmgr --create --disk %s --part 1 --label \"Arch Linux (fallback)\" --loader '\\EFI\\Linux\\arch-%s-fallback.efi'",
+            app->disks[app->disk_plan.members[0]].device_path, kernel);
+        archinstallus_cmd_add(
+            app, "Create boot entry",
+            "efibootmgr --create --disk %s --part 1 --label \"Arch Linux\" --loader '\\EFI\\Linux\\arch-%s.efi'",
+            app->disks[app->disk_plan.members[0]].device_path, kernel);
+        break;
+    default:
+        // grub-mkconfig derives root= itself, so the generated cmdline is only used by UKIs
+        if(!app->disk_plan.bios_boot_part) {
+            archinstallus_cmd_add(
+                app, "Installing GRUB", "grub-install --target=x86_64-efi --efi-directory=/boot/efi --bootloader-id=GRUB");
+        } else {
+            archinstallus_cmd_add(
+                app, "Installing GRUB", "grub-install --target=i386-pc %s",
+                app->disks[app->disk_plan.members[0]].device_path);
+        }
+        archinstallus_cmd_add(app, "Creating boot entries", "grub-mkconfig -o /boot/grub/grub.cfg");
+        break;
     }
     
-    return true;
+    archinstallus_log(app, "Boot: %s, cmdline: %s", bootloader_names[bootloader], cmdline);
+    return archinstallus_chroot_run(app, "Boot", 700);
 }
 
 static bool archinstallus_setup_network(ArchInstallusComplete* app) {
@@ -438,74 +3345,64 @@ static bool archinstallus_setup_network(ArchInstallusComplete* app) {
     snprintf(app->status_message, sizeof(app->status_message), "Configuring network...");
     app->step_progress = 0;
     
-    // Real network configuration
-    const char* network_steps[] = {
-        "Starting NetworkManager",
-        "Configuring WiFi",
-        "Setting up ethernet",
-        "Configuring firewall",
-        "Setting up VPN (if configured)"
-    };
-    
-    int total_steps = sizeof(network_steps) / sizeof(network_steps[0]);
-    
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(500);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "Network %d/%d: %s", i + 1, total_steps, network_steps[i]);
+    // Real network configuration; NetworkManager also handles ethernet DHCP
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Starting NetworkManager", "systemctl enable NetworkManager.service");
+    archinstallus_cmd_add(
+        app, "Configuring WiFi", "printf '[device]\\nwifi.backend=wpa_supplicant\\n' > /etc/NetworkManager/conf.d/wifi-backend.conf");
+    archinstallus_cmd_add(app, "Configuring DNS", "systemctl enable systemd-resolved.service");
+    if(archinstallus_has_package(app->config, "ufw")) {
+        archinstallus_cmd_add(app, "Configuring firewall", "ufw default deny incoming && sed -i 's/^ENABLED=no/ENABLED=yes/' /etc/ufw/ufw.conf");
     }
     
-    return true;
+    return archinstallus_chroot_run(app, "Network", 150);
 }
 
 static bool archinstallus_setup_users(ArchInstallusComplete* app) {
     app->state = STATE_USER_SETUP;
     snprintf(app->status_message, sizeof(app->status_message), "Setting up users...");
     app->step_progress = 0;
+    const InstallConfig* config = app->config;
     
     // Real user management
-    const char* user_steps[] = {
-        "Creating user account",
-        "Setting user permissions",
-        "Configuring user groups",
-        "Setting up home directory",
-        "Configuring shell"
-    };
-    
-    int total_steps = sizeof(user_steps) / sizeof(user_steps[0]);
-    
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(400);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "User %d/%d: %s", i + 1, total_steps, user_steps[i]);
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Creating user account", "useradd -m -G wheel -s /bin/bash %s", config->username);
+    archinstallus_cmd_add(app, "Configuring user groups", "usermod -aG audio,video,storage,input %s", config->username);
+    // Session stdin is /dev/null, so each password is a heredoc inside its command, masked in the log
+    if(config->password[0]) {
+        archinstallus_cmd_add_input(app, "Setting passwords", "chpasswd", config->username, config->password);
+    }
+    if(config->root_password[0]) {
+        archinstallus_cmd_add_input(app, "Setting passwords", "chpasswd", "root", config->root_password);
     }
+    archinstallus_cmd_add(app, "Setting up home directory", "chmod 700 /home/%s", config->username);
     
-    return true;
+    return archinstallus_chroot_run(app, "User", 150);
 }
 
 static bool archinstallus_configure_services(ArchInstallusComplete* app) {
     app->state = STATE_SERVICE_CONFIG;
     snprintf(app->status_message, sizeof(app->status_message), "Configuring services...");
     app->step_progress = 0;
+    const InstallConfig* config = app->config;
     
     // Real service configuration
-    const char* service_steps[] = {
-        "Starting systemd services",
-        "Configuring SSH",
-        "Setting up firewall services",
-        "Configuring printer services",
-        "Setting up backup services"
-    };
-    
-    int total_steps = sizeof(service_steps) / sizeof(service_steps[0]);
-    
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(500);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "Service %d/%d: %s", i + 1, total_steps, service_steps[i]);
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Starting systemd services", "systemctl enable systemd-timesyncd.service");
+    if(app->disks[app->disk_plan.members[0]].is_ssd) {
+        archinstallus_cmd_add(app, "Enabling TRIM", "systemctl enable fstrim.timer");
+    }
+    if(archinstallus_has_package(config, "openssh")) {
+        archinstallus_cmd_add(app, "Configuring SSH", "systemctl enable sshd.service");
+    }
+    if(archinstallus_has_package(config, "ufw")) {
+        archinstallus_cmd_add(app, "Setting up firewall services", "systemctl enable ufw.service");
+    }
+    if(config->enable_automated_backups && archinstallus_has_package(config, "snapper")) {
+        archinstallus_cmd_add(app, "Setting up backup services", "systemctl enable snapper-timeline.timer snapper-cleanup.timer");
     }
     
-    return true;
+    return archinstallus_chroot_run(app, "Service", 150);
 }
 
 static bool archinstallus_optimize_system(ArchInstallusComplete* app) {
@@ -528,161 +3425,970 @@ static bool archinstallus_optimize_system(ArchInstallusComplete* app) {
     int total_steps = sizeof(optimization_steps) / sizeof(optimization_steps[0]);
     
     for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(600);
+        archinstallus_trace_begin(app, optimization_steps[i]);
+        archinstallus_wait(app, 600);
         app->step_progress = ((i + 1) * 100) / total_steps;
         snprintf(app->status_message, sizeof(app->status_message), "Optimize %d/%d: %s", i + 1, total_steps, optimization_steps[i]);
+        archinstallus_trace_end(app);
     }
     
     return true;
 }
 
+// mkinitcpio compressors, both fast to decompress; ratio is compressed size in % of the cpio
+static const InitramfsCompressor initramfs_compressors[] = {
+    {"zstd", "-3", 34},
+    {"lz4", "-l", 52},
+};
+
+// Append a space-separated word to a mkinitcpio array
+static void archinstallus_initramfs_add(char* list, size_t size, const char* word, uint32_t* kib, uint32_t word_kib) {
+    size_t len = strlen(list);
+    snprintf(list + len, size - len, "%s%s", len ? " " : "", word);
+    *kib += word_kib;
+}
+
+// Replies to zstd -b / lz4 -b (default levels, 3 and 1, as mkinitcpio uses) for initramfs_compressors,
+// in order, taken on the cpuinfo_sample machine and used until the target can send them back
+static const char* const initramfs_benchmark_samples[] = {
+    " 3#Synthetic 50%     :  10000000 ->   3154223 (x3.170),  305.3 MB/s, 1258.3 MB/s\n",
+    " 1#Synthetic 50%     :  10000000 ->   5859357 (x1.707),  720.2 MB/s, 4089.5 MB/s\n",
+};
+_Static_assert(COUNT_OF(initramfs_benchmark_samples) == COUNT_OF(initramfs_compressors), "one sample reply per compressor");
+
+// Decompression speed, MiB/s, from the second rate of the benchmark line; 0 if the reply has none
+static uint32_t archinstallus_initramfs_benchmark(ArchInstallusComplete* app, size_t index) {
+    archinstallus_log(app, "%s -b", initramfs_compressors[index].name);
+    archinstallus_wait(app, 300);
+    uint32_t tenths[2];
+    if(archinstallus_parse_rates(initramfs_benchmark_samples[index], " MB/s", tenths, 2) != 2) return 0;
+    return (uint32_t)((uint64_t)tenths[1] * 100000 / (1024 * 1024));
+}
+
+// Hooks and modules from the disk plan, compressor from the estimated unpack time with sample
+// decompression speeds
+static void archinstallus_plan_initramfs(ArchInstallusComplete* app) {
+    InitramfsPlan* initramfs = &app->initramfs;
+    DiskPlan* plan = &app->disk_plan;
+    memset(initramfs, 0, sizeof(InitramfsPlan));
+    
+    // systemd + autodetect base image; everything else only when the root device needs it
+    uint32_t cpio_kib = 9216;
+    archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "base systemd autodetect microcode modconf", &cpio_kib, 0);
+    if(plan->encrypted) {
+        archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "keyboard sd-vconsole", &cpio_kib, 300);
+    }
+    archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "block", &cpio_kib, 0);
+    if(plan->layout == DiskLayoutRaid0 || plan->layout == DiskLayoutRaid1) {
+        archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "mdadm_udev", &cpio_kib, 700);
+    }
+    if(plan->layout != DiskLayoutSingle) {
+        archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "lvm2", &cpio_kib, 2400);
+    }
+    if(plan->encrypted) {
+        archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "sd-encrypt", &cpio_kib, 2800);
+    }
+    archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "filesystems", &cpio_kib, 0);
+    if(strcmp(app->config->root_filesystem, "ext4") == 0) {
+        archinstallus_initramfs_add(initramfs->hooks, sizeof(initramfs->hooks), "fsck", &cpio_kib, 400);
+    }
+    
+    // Storage drivers for every array member, loaded up front instead of waiting on coldplug
+    bool nvme = false;
+    bool sata = false;
+    for(uint32_t i = 0; i < plan->member_count; i++) {
+        if(strncmp(app->disks[plan->members[i]].device_path, "/dev/nvme", 9) == 0) {
+            nvme = true;
+        } else {
+            sata = true;
+        }
+    }
+    if(nvme) archinstallus_initramfs_add(initramfs->modules, sizeof(initramfs->modules), "nvme", &cpio_kib, 160);
+    if(sata) archinstallus_initramfs_add(initramfs->modules, sizeof(initramfs->modules), "ahci sd_mod", &cpio_kib, 220);
+    if(plan->layout == DiskLayoutRaid0) archinstallus_initramfs_add(initramfs->modules, sizeof(initramfs->modules), "raid0", &cpio_kib, 60);
+    if(plan->layout == DiskLayoutRaid1) archinstallus_initramfs_add(initramfs->modules, sizeof(initramfs->modules), "raid1", &cpio_kib, 120);
+    if(plan->encrypted) {
+        bool aes = strncmp(app->luks.cipher->name, "aes", 3) == 0;
+        archinstallus_initramfs_add(
+            initramfs->modules, sizeof(initramfs->modules), aes ? "dm_crypt aesni_intel" : "dm_crypt adiantum nhpoly1305 chacha_x86_64",
+            &cpio_kib, aes ? 240 : 180);
+    }
+    archinstallus_initramfs_add(
+        initramfs->modules, sizeof(initramfs->modules), app->config->root_filesystem, &cpio_kib,
+        strcmp(app->config->root_filesystem, "ext4") == 0 ? 900 : 2200);
+    
+    // Firmware reads the image from the ESP, then the kernel decompresses it single-threaded
+    const DiskInfo* boot_disk = &app->disks[plan->members[0]];
+    uint32_t read_mibs = strncmp(boot_disk->device_path, "/dev/nvme", 9) == 0 ? 800 : boot_disk->is_ssd ? 400 : 100;
+    for(size_t i = 0; i < COUNT_OF(initramfs_compressors); i++) {
+        const InitramfsCompressor* compressor = &initramfs_compressors[i];
+        archinstallus_trace_begin(app, "Compressor benchmark");
+        uint32_t decompress_mibs = archinstallus_initramfs_benchmark(app, i);
+        archinstallus_trace_end(app);
+        if(!decompress_mibs) {
+            archinstallus_log(app, "Initramfs: no figures in the %s benchmark reply", compressor->name);
+            continue;
+        }
+        
+        uint32_t size_kib = cpio_kib * compressor->ratio_pct / 100;
+        uint32_t unpack_ms = size_kib * 1000 / 1024 / read_mibs + cpio_kib * 1000 / 1024 / decompress_mibs;
+        archinstallus_log(
+            app, "Initramfs (sample benchmark): %s %lu KiB, %lu MiB/s -> %lu ms", compressor->name, size_kib, decompress_mibs, unpack_ms);
+        if(!initramfs->compressor || unpack_ms < initramfs->unpack_ms) {
+            initramfs->compressor = compressor;
+            initramfs->size_kib = size_kib;
+            initramfs->unpack_ms = unpack_ms;
+        }
+    }
+    if(!initramfs->compressor) {
+        // mkinitcpio's own default
+        initramfs->compressor = &initramfs_compressors[0];
+        initramfs->size_kib = cpio_kib * initramfs->compressor->ratio_pct / 100;
+        archinstallus_log(app, "Initramfs: no benchmark figures, keeping %s", initramfs->compressor->name);
+    }
+    initramfs->cpio_kib = cpio_kib;
+}
+
 static bool archinstallus_cleanup_system(ArchInstallusComplete* app) {
     app->state = STATE_CLEANUP;
     snprintf(app->status_message, sizeof(app->status_message), "Cleaning up...");
     app->step_progress = 0;
     
-    // Real cleanup
-    const char* cleanup_steps[] = {
-        "Unmounting temporary directories",
-        "Removing temporary files",
-        "Updating package databases",
-        "Generating initramfs",
-        "Updating system database"
-    };
+    archinstallus_trace_begin(app, "Initramfs plan");
+    archinstallus_plan_initramfs(app);
+    archinstallus_trace_end(app);
+    InitramfsPlan* initramfs = &app->initramfs;
     
-    int total_steps = sizeof(cleanup_steps) / sizeof(cleanup_steps[0]);
+    // Last work inside the target, then the session goes before anything is unmounted
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Write mkinitcpio.conf", "echo 'MODULES=(%s)' > /etc/mkinitcpio.conf", initramfs->modules);
+    archinstallus_cmd_add(app, "Write mkinitcpio.conf", "echo 'HOOKS=(%s)' >> /etc/mkinitcpio.conf", initramfs->hooks);
+    archinstallus_cmd_add(app, "Write mkinitcpio.conf", "echo 'COMPRESSION=\"%s\"' >> /etc/mkinitcpio.conf", initramfs->compressor->name);
+    archinstallus_cmd_add(
+        app, "Write mkinitcpio.conf", "echo 'COMPRESSION_OPTIONS=(%s)' >> /etc/mkinitcpio.conf", initramfs->compressor->options);
+    archinstallus_cmd_add(app, "Generating initramfs", "mkinitcpio -P");
+    bool result = archinstallus_chroot_run(app, "Cleanup", 400);
+    archinstallus_chroot_close(app);
+    if(!result) return false;
     
-    for(int i = 0; i < total_steps; i++) {
-        furi_delay_ms(400);
-        app->step_progress = ((i + 1) * 100) / total_steps;
-        snprintf(app->status_message, sizeof(app->status_message), "Cleanup %d/%d: %s", i + 1, total_steps, cleanup_steps[i]);
+    // Host-side scratch; the fleet's staging cache is shared with pipelines that may still be running
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Removing temporary files", "rm -rf " VERIFY_DIR);
+    if(!app->fleet) archinstallus_cmd_add(app, "Removing temporary files", "rm -rf " FLEET_CACHE_DIR);
+    archinstallus_cmd_add(app, "Flushing writes", "sync");
+    result = archinstallus_cmd_run(app, "Cleanup", 400);
+    if(result) {
+        archinstallus_log(
+            app,
+            "Initramfs: %s, %lu KiB (cpio %lu KiB), est. unpack %lu ms; hooks: %s",
+            initramfs->compressor->name,
+            initramfs->size_kib,
+            initramfs->cpio_kib,
+            initramfs->unpack_ms,
+            initramfs->hooks);
+    }
+    return result;
+}
+
+typedef bool (*ArchInstallusStep)(ArchInstallusComplete* app);
+
+// Run one top-level step inside its own trace span
+static bool archinstallus_run_step(ArchInstallusComplete* app, const char* name, ArchInstallusStep step) {
+    archinstallus_memory_log(app, name);
+    archinstallus_trace_begin(app, name);
+    bool result = step(app);
+    archinstallus_trace_end(app);
+    return result;
+}
+
+// Snapshot-based rollback for the post-install stages. Snapshots are copy-on-write
+// (btrfs subvolumes or LVM thin volumes), so taking and restoring one is constant-time.
+static bool archinstallus_snapshot_take(ArchInstallusComplete* app, const char* key) {
+    DiskPlan* plan = &app->disk_plan;
+    if(plan->snapshot_backend == SnapshotBackendNone) return true;
+    
+    archinstallus_cmd_reset(app);
+    if(plan->snapshot_backend == SnapshotBackendBtrfs) {
+        archinstallus_cmd_add(app, "Snapshot", "btrfs subvolume snapshot -r " SNAPSHOT_BTRFS_TOP "/@ " SNAPSHOT_BTRFS_TOP "/@snap-%s", key);
+    } else {
+        archinstallus_cmd_add(app, "Snapshot", "sync; lvcreate -s -kn -n root-%s arch/root", key);
     }
+    archinstallus_trace_begin(app, "Snapshot");
+    bool result = archinstallus_cmd_run(app, "Snapshot", 100) && !archinstallus_inject_failure(app, "snapshot");
+    archinstallus_trace_end(app);
+    if(!result) return false;
     
+    // The old snapshot goes only once the key names the new one; a failed drop leaves a stale
+    // snapshot on disk but never a stale rollback target
+    const char* old_key = app->snapshot_key;
+    app->snapshot_key = key;
+    if(!old_key) return true;
+    archinstallus_cmd_reset(app);
+    if(plan->snapshot_backend == SnapshotBackendBtrfs) {
+        archinstallus_cmd_add(app, "Drop old snapshot", "btrfs subvolume delete " SNAPSHOT_BTRFS_TOP "/@snap-%s", old_key);
+    } else {
+        archinstallus_cmd_add(app, "Drop old snapshot", "lvremove -y arch/root-%s", old_key);
+    }
+    if(!archinstallus_cmd_run(app, "Snapshot", 100)) archinstallus_log(app, "Snapshot: could not drop %s, left on disk", old_key);
     return true;
 }
 
-static int32_t archinstallus_perform_installation(void* ctx) {
-    FURI_LOG_I(TAG, "Starting COMPLETE ArchInstallus installation");
+// Installation finished: the last snapshot is no longer needed
+static void archinstallus_snapshot_release(ArchInstallusComplete* app) {
+    if(!app->snapshot_key) return;
+    archinstallus_cmd_reset(app);
+    if(app->disk_plan.snapshot_backend == SnapshotBackendBtrfs) {
+        archinstallus_cmd_add(app, "Drop old snapshot", "btrfs subvolume delete " SNAPSHOT_BTRFS_TOP "/@snap-%s", app->snapshot_key);
+        archinstallus_cmd_add(app, "Unmount btrfs top level", "umount " SNAPSHOT_BTRFS_TOP);
+    } else {
+        archinstallus_cmd_add(app, "Drop old snapshot", "lvremove -y arch/root-%s", app->snapshot_key);
+    }
+    archinstallus_cmd_run(app, "Snapshot", 100);
+    app->snapshot_key = NULL;
+}
+
+// Throw away everything after the last good snapshot and remount the restored root
+static bool archinstallus_snapshot_rollback(ArchInstallusComplete* app) {
+    DiskPlan* plan = &app->disk_plan;
+    if(plan->snapshot_backend == SnapshotBackendNone || !app->rollback_enabled || !app->snapshot_key) return false;
     
-    // Step 1: Hardware detection
-    // Cast the context to our app pointer
-    ArchInstallusComplete* app = (ArchInstallusComplete*)ctx;
+    // The session holds mounts under /mnt
+    archinstallus_chroot_close(app);
+    archinstallus_cmd_reset(app);
+    archinstallus_cmd_add(app, "Unmount target", "umount -R /mnt");
+    if(plan->snapshot_backend == SnapshotBackendBtrfs) {
+        archinstallus_cmd_add(app, "Drop failed root", "btrfs subvolume delete " SNAPSHOT_BTRFS_TOP "/@");
+        archinstallus_cmd_add(
+            app, "Restore root", "btrfs subvolume snapshot " SNAPSHOT_BTRFS_TOP "/@snap-%s " SNAPSHOT_BTRFS_TOP "/@", app->snapshot_key);
+    } else {
+        // LUKS sits on the logical volume, so the mapping has to go before the volume is swapped
+        if(plan->encrypted) archinstallus_cmd_add(app, "Close root", "cryptsetup close cryptroot");
+        archinstallus_cmd_add(app, "Drop failed root", "lvremove -y arch/root");
+        archinstallus_cmd_add(app, "Restore root", "lvcreate -s -kn -n root arch/root-%s", app->snapshot_key);
+        if(plan->encrypted) archinstallus_cmd_add(app, "Open root", "cryptsetup open --key-file=- %s cryptroot", plan->root_luks_device);
+    }
+    archinstallus_add_mount_commands(app);
     
+    archinstallus_log(app, "Rollback: restoring snapshot %s", app->snapshot_key);
+    archinstallus_trace_begin(app, "Rollback");
+    bool result = archinstallus_cmd_run(app, "Rollback", 200);
+    archinstallus_trace_end(app);
+    return result;
+}
+
+// Post-install stages; each successful one is followed by a snapshot, a failed one is rolled back and retried
+typedef struct {
+    const char* name;
+    const char* key; // snapshot / failure injection name
+    ArchInstallusStep step;
+    const char* error;
+    uint32_t progress;
+} PipelineStage;
+
+static const PipelineStage post_install_stages[] = {
+    {"Configure", "configure", archinstallus_configure_system, "Configuration failed", 80},
+    {"Bootloader", "bootloader", archinstallus_setup_bootloader, "Bootloader setup failed", 82},
+    {"Network setup", "network", archinstallus_setup_network, "Network setup failed", 84},
+    {"User setup", "users", archinstallus_setup_users, "User setup failed", 86},
+    {"Service config", "services", archinstallus_configure_services, "Service config failed", 88},
+    {"Optimization", "optimize", archinstallus_optimize_system, "Optimization failed", 95},
+    {"Cleanup", "cleanup", archinstallus_cleanup_system, "Cleanup failed", 100},
+};
+
+static int32_t archinstallus_run_pipeline(ArchInstallusComplete* app) {
     // Step 1: Hardware detection
-    if(!archinstallus_detect_hardware(app)) {
+    if(!archinstallus_run_step(app, "Hardware detection", archinstallus_detect_hardware)) {
         snprintf(app->error_message, sizeof(app->error_message), "Hardware detection failed");
         return -1;
     }
     app->total_progress = 5;
     
     // Step 2: Disk detection
-    if(!archinstallus_detect_disks(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "No disks detected");
+    if(!archinstallus_run_step(app, "Disk detection", archinstallus_detect_disks)) {
+        snprintf(app->error_message, sizeof(app->error_message), app->disk_count ? "Disk plan failed" : "No disks detected");
         return -1;
     }
     app->total_progress = 10;
     
+#if ARCHINSTALLUS_WITH_BACKUP
+    // Restore mode replaces the whole install
+    if(app->config->backup_restore) {
+        if(!archinstallus_run_step(app, "Restore", archinstallus_restore_backup)) {
+            snprintf(app->error_message, sizeof(app->error_message), "Restore failed");
+            return -1;
+        }
+        app->total_progress = 100;
+        app->state = STATE_COMPLETE;
+        snprintf(app->status_message, sizeof(app->status_message), "Restore complete!");
+        return 0;
+    }
+#endif
+    
     // Step 3: Network detection
-    if(!archinstallus_detect_network(app)) {
+    if(!archinstallus_run_step(app, "Network detection", archinstallus_detect_network)) {
         snprintf(app->error_message, sizeof(app->error_message), "Network unavailable");
         return -1;
     }
     app->total_progress = 15;
     
+    // Package downloads overlap partitioning, formatting and mounting
+    archinstallus_prefetch_start(app);
+    
     // Step 4: Partitioning
-    if(!archinstallus_partition_disk(app)) {
+    if(!archinstallus_run_step(app, "Partitioning", archinstallus_partition_disk)) {
         snprintf(app->error_message, sizeof(app->error_message), "Partitioning failed");
         return -1;
     }
     app->total_progress = 30;
     
     // Step 5: Formatting
-    if(!archinstallus_format_partitions(app)) {
+    if(!archinstallus_run_step(app, "Formatting", archinstallus_format_partitions)) {
         snprintf(app->error_message, sizeof(app->error_message), "Formatting failed");
         return -1;
     }
     app->total_progress = 40;
     
     // Step 6: Mounting
-    if(!archinstallus_mount_filesystems(app)) {
+    if(!archinstallus_run_step(app, "Mounting", archinstallus_mount_filesystems)) {
         snprintf(app->error_message, sizeof(app->error_message), "Mounting failed");
         return -1;
     }
     app->total_progress = 50;
     
     // Step 7: Download base system
-    if(!archinstallus_download_base_system(app)) {
+    if(!archinstallus_run_step(app, "Download", archinstallus_download_base_system)) {
         snprintf(app->error_message, sizeof(app->error_message), "Download failed");
         return -1;
     }
     app->total_progress = 65;
     
     // Step 8: Install system
-    if(!archinstallus_install_system(app)) {
+    if(!archinstallus_run_step(app, "Install", archinstallus_install_system)) {
         snprintf(app->error_message, sizeof(app->error_message), "Installation failed");
         return -1;
     }
-    app->total_progress = 75;
+    app->total_progress = 72;
     
-    // Step 9: Configure system
-    if(!archinstallus_configure_system(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "Configuration failed");
+    // Step 8b: Verify installed files
+    if(!archinstallus_run_step(app, "Verify", archinstallus_verify_system)) {
+        snprintf(app->error_message, sizeof(app->error_message), "Verification failed");
         return -1;
     }
-    app->total_progress = 80;
+    app->total_progress = 75;
     
-    // Step 10: Setup bootloader
-    if(!archinstallus_setup_bootloader(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "Bootloader setup failed");
+    // Steps 9-15: post-install stages, rolled back to the last good snapshot and retried on failure
+    app->snapshot_key = NULL;
+    app->injected_failures = 0;
+    // A failed snapshot fails the run: rolling back to an older one would silently undo a stage
+    if(app->rollback_enabled && app->disk_plan.snapshot_backend != SnapshotBackendNone &&
+       !archinstallus_snapshot_take(app, "installed")) {
+        snprintf(app->error_message, sizeof(app->error_message), "Snapshot failed");
         return -1;
     }
-    app->total_progress = 82;
+    for(size_t i = 0; i < COUNT_OF(post_install_stages); i++) {
+        const PipelineStage* stage = &post_install_stages[i];
+        app->stage_key = stage->key;
+        bool ok = archinstallus_run_step(app, stage->name, stage->step) && !archinstallus_inject_failure(app, stage->key);
+        for(uint32_t retry = 0; !ok && retry < SNAPSHOT_MAX_RETRIES && archinstallus_snapshot_rollback(app); retry++) {
+            archinstallus_log(app, "Rollback: retrying %s (%lu/%u)", stage->name, retry + 1, SNAPSHOT_MAX_RETRIES);
+            ok = archinstallus_run_step(app, stage->name, stage->step) && !archinstallus_inject_failure(app, stage->key);
+        }
+        if(!ok) {
+            app->stage_key = NULL;
+            archinstallus_chroot_close(app);
+            snprintf(app->error_message, sizeof(app->error_message), "%s", stage->error);
+            return -1;
+        }
+        app->total_progress = stage->progress;
+        
+        // Cleanup is last, nothing left to roll back to after it
+        if(i + 1 < COUNT_OF(post_install_stages) && app->snapshot_key && !archinstallus_snapshot_take(app, stage->key)) {
+            app->stage_key = NULL;
+            archinstallus_chroot_close(app);
+            snprintf(app->error_message, sizeof(app->error_message), "Snapshot failed");
+            return -1;
+        }
+    }
+    app->stage_key = NULL;
+    archinstallus_chroot_close(app);
+    archinstallus_snapshot_release(app);
     
-    // Step 11: Network setup
-    if(!archinstallus_setup_network(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "Network setup failed");
-        return -1;
+    app->state = STATE_COMPLETE;
+    snprintf(app->status_message, sizeof(app->status_message), "Installation complete!");
+    
+    return 0;
+}
+
+#if ARCHINSTALLUS_WITH_FLEET
+// Fleet mode: N pipelines, each an isolated ArchInstallusComplete sharing config, log and budgets
+typedef struct {
+    ArchInstallusComplete* app;
+    ArchInstallusComplete* pipeline;
+    FuriThread* thread;
+    uint8_t index;
+} FleetWorker;
+
+static ArchInstallusComplete* archinstallus_pipeline_alloc(ArchInstallusComplete* app) {
+    ArchInstallusComplete* pipeline = malloc(sizeof(ArchInstallusComplete));
+    memset(pipeline, 0, sizeof(ArchInstallusComplete));
+    pipeline->config = app->config;
+    pipeline->storage = app->storage;
+    pipeline->notifications = app->notifications;
+    pipeline->log_buffer = app->log_buffer;
+    pipeline->log_mutex = app->log_mutex;
+    pipeline->start_time = app->start_time;
+    pipeline->rollback_enabled = app->rollback_enabled;
+    pipeline->fleet = app->fleet;
+    pipeline->gui_thread_id = app->gui_thread_id;
+    return pipeline;
+}
+
+static void archinstallus_pipeline_reset(ArchInstallusComplete* pipeline, const char* target_name, const char* target_disks) {
+    pipeline->state = STATE_IDLE;
+    pipeline->step_progress = 0;
+    pipeline->total_progress = 0;
+    pipeline->status_message[0] = '\0';
+    pipeline->error_message[0] = '\0';
+    pipeline->disk_count = 0;
+    pipeline->backup_created = false;
+    pipeline->target_name = target_name;
+    pipeline->target_disks = target_disks;
+    archinstallus_trace_reset(pipeline);
+}
+
+static int32_t archinstallus_fleet_worker(void* ctx) {
+    FleetWorker* worker = ctx;
+    ArchInstallusFleet* fleet = worker->app->fleet;
+    ArchInstallusComplete* pipeline = worker->pipeline;
+
+    while(true) {
+        furi_mutex_acquire(fleet->mutex, FuriWaitForever);
+        uint32_t index = fleet->next_target++;
+        if(index < fleet->target_count) {
+            fleet->targets[index].status = FleetTargetRunning;
+            fleet->targets[index].worker = worker->index;
+            fleet->targets[index].start_tick = furi_get_tick();
+        }
+        furi_mutex_release(fleet->mutex);
+        if(index >= fleet->target_count) break;
+
+        InstallConfig* config = worker->app->config;
+        archinstallus_pipeline_reset(pipeline, config->fleet_targets[index], config->fleet_target_disks[index]);
+        int32_t result = archinstallus_run_pipeline(pipeline);
+        archinstallus_prefetch_stop(pipeline);
+        archinstallus_trace_export(pipeline, result == 0);
+
+        furi_mutex_acquire(fleet->mutex, FuriWaitForever);
+        FleetTarget* target = &fleet->targets[index];
+        target->end_tick = furi_get_tick();
+        target->state = pipeline->state;
+        target->status = result == 0 ? FleetTargetDone : FleetTargetFailed;
+        snprintf(target->error, sizeof(target->error), "%s", pipeline->error_message);
+        furi_mutex_release(fleet->mutex);
+    }
+
+    return 0;
+}
+
+static int32_t archinstallus_fleet_run(ArchInstallusComplete* app) {
+    InstallConfig* config = app->config;
+    ArchInstallusFleet* fleet = malloc(sizeof(ArchInstallusFleet));
+    memset(fleet, 0, sizeof(ArchInstallusFleet));
+    fleet->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    fleet->net_budget = furi_semaphore_alloc(config->fleet_net_slots, config->fleet_net_slots);
+    fleet->io_budget = furi_semaphore_alloc(config->fleet_io_slots, config->fleet_io_slots);
+    fleet->target_count = config->fleet_target_count;
+    app->fleet = fleet;
+    app->state = STATE_INSTALLING;
+
+    // Concurrency is bounded by config, target count and what the heap can hold
+    FleetWorker workers[FLEET_MAX_WORKERS];
+    uint32_t wanted = MIN(MIN(config->fleet_workers, fleet->target_count), (uint32_t)FLEET_MAX_WORKERS);
+    uint32_t worker_count = 0;
+    uint32_t start = furi_get_tick();
+
+    while(worker_count < wanted &&
+          memmgr_heap_get_max_free_block() >=
+              sizeof(ArchInstallusComplete) + INSTALLER_STACK_SIZE + sizeof(PackagePrefetch) + PREFETCH_STACK_SIZE +
+                  FLEET_HEAP_RESERVE) {
+        FleetWorker* worker = &workers[worker_count];
+        worker->app = app;
+        worker->index = worker_count;
+        worker->pipeline = archinstallus_pipeline_alloc(app);
+        // Workers run the same pipeline as the single-target installer thread
+        worker->thread = furi_thread_alloc_ex("ArchFleetWorker", INSTALLER_STACK_SIZE, archinstallus_fleet_worker, worker);
+        furi_thread_start(worker->thread);
+        worker_count++;
+    }
+    archinstallus_log(app, "Fleet: %lu targets, %lu/%lu workers, net %lu, io %lu", fleet->target_count, worker_count, wanted, config->fleet_net_slots, config->fleet_io_slots);
+
+    if(worker_count == 0) {
+        snprintf(app->error_message, sizeof(app->error_message), "Not enough memory for fleet");
+    }
+
+    // Aggregate per-target status until every target has finished
+    uint32_t done = 0;
+    uint32_t failed = 0;
+    while(worker_count > 0) {
+        uint32_t progress = 0;
+        uint32_t active = 0;
+        done = 0;
+        failed = 0;
+
+        furi_mutex_acquire(fleet->mutex, FuriWaitForever);
+        for(uint32_t i = 0; i < fleet->target_count; i++) {
+            FleetTarget* target = &fleet->targets[i];
+            if(target->status == FleetTargetRunning) {
+                active++;
+                progress += workers[target->worker].pipeline->total_progress;
+            } else if(target->status == FleetTargetDone) {
+                done++;
+                progress += 100;
+            } else if(target->status == FleetTargetFailed) {
+                failed++;
+                progress += 100;
+            }
+        }
+        furi_mutex_release(fleet->mutex);
+
+        app->total_progress = progress / fleet->target_count;
+        app->step_progress = ((done + failed) * 100) / fleet->target_count;
+        snprintf(app->status_message, sizeof(app->status_message), "Fleet %lu/%lu ok, %lu fail, %lu run", done, fleet->target_count, failed, active);
+        if(done + failed == fleet->target_count) break;
+        furi_delay_ms(250);
+    }
+
+    for(uint32_t i = 0; i < worker_count; i++) {
+        furi_thread_join(workers[i].thread);
+        furi_thread_free(workers[i].thread);
+        free(workers[i].pipeline);
     }
-    app->total_progress = 84;
+
+    // Per-target summary and effective parallelism (busy time / wall time)
+    uint32_t elapsed = furi_get_tick() - start;
+    uint32_t busy = 0;
+    for(uint32_t i = 0; i < fleet->target_count; i++) {
+        FleetTarget* target = &fleet->targets[i];
+        uint32_t duration = target->end_tick - target->start_tick;
+        if(target->status == FleetTargetDone || target->status == FleetTargetFailed) busy += duration;
+        archinstallus_log(
+            app,
+            "Fleet: %s %s in %lu ms%s%s",
+            config->fleet_targets[i],
+            target->status == FleetTargetDone ? "ok" : target->status == FleetTargetFailed ? "FAILED" : "not run",
+            duration,
+            target->error[0] ? " - " : "",
+            target->error);
+    }
+    archinstallus_log(
+        app,
+        "Fleet: %lu ok, %lu failed in %lu ms, parallelism x%lu.%02lu, cache %lu hits / %lu misses",
+        done,
+        failed,
+        elapsed,
+        elapsed ? busy / elapsed : 0,
+        elapsed ? (busy * 100 / elapsed) % 100 : 0,
+        fleet->cache_hits,
+        fleet->cache_misses);
+
+    app->fleet = NULL;
+    furi_semaphore_free(fleet->net_budget);
+    furi_semaphore_free(fleet->io_budget);
+    furi_mutex_free(fleet->mutex);
+    free(fleet);
+
+    bool success = worker_count > 0 && failed == 0;
+    app->state = success ? STATE_COMPLETE : STATE_ERROR;
+    app->total_progress = 100;
+    snprintf(app->status_message, sizeof(app->status_message), "Fleet done: %lu ok, %lu failed", done, failed);
+    return success ? 0 : -1;
+}
+#endif
+
+static int32_t archinstallus_perform_installation(void* ctx) {
+    FURI_LOG_I(TAG, "Starting COMPLETE ArchInstallus installation");
     
-    // Step 12: User setup
-    if(!archinstallus_setup_users(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "User setup failed");
-        return -1;
+    // Cast the context to our app pointer
+    ArchInstallusComplete* app = (ArchInstallusComplete*)ctx;
+    app->installer_stack_free = furi_thread_get_stack_space(furi_thread_get_current_id());
+    
+    int32_t result;
+#if ARCHINSTALLUS_WITH_FLEET
+    if(app->config->fleet_target_count > 0) {
+        result = archinstallus_fleet_run(app);
+    } else
+#endif
+    {
+        archinstallus_trace_reset(app);
+        result = archinstallus_run_pipeline(app);
+        archinstallus_prefetch_stop(app);
+        archinstallus_trace_export(app, result == 0);
+        
+        // Back resets from here; without it a failed run stays "running" on the failed step
+        if(result != 0) {
+            archinstallus_log(app, "Failed: %s", app->error_message);
+            app->state = STATE_ERROR;
+            snprintf(app->status_message, sizeof(app->status_message), "Error: %s", app->error_message);
+        }
     }
-    app->total_progress = 86;
     
-    // Step 13: Service configuration
-    if(!archinstallus_configure_services(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "Service config failed");
-        return -1;
+    archinstallus_memory_log(app, "Installer exit");
+    return result;
+}
+
+#if ARCHINSTALLUS_WITH_EDITOR
+// Packages offered by the editor, sorted so prefix search is a binary search
+static const char* const package_catalog[] = {
+    "alacritty", "android-tools", "ansible", "apache", "arch-install-scripts", "aria2", "audacity",
+    "base-devel", "bat", "bind", "bind-tools", "blender", "bluez", "bluez-utils", "bpytop", "btop",
+    "btrfs-progs", "buildah", "cargo", "ccache", "chromium", "clang", "cmake", "cockpit", "code",
+    "cpupower", "cronie", "cryptsetup", "ctags", "curl", "darktable", "dbeaver", "ddrescue", "deno",
+    "dialog", "distcc", "dnsmasq", "docker", "docker-buildx", "docker-compose", "dosfstools",
+    "dotnet-sdk", "e2fsprogs", "emacs", "ethtool", "exfatprogs", "eza", "fail2ban", "fd", "ffmpeg",
+    "firefox", "firewalld", "fish", "flatpak", "fwupd", "fzf", "gcc", "gdb", "gimp", "git",
+    "git-lfs", "github-cli", "gnome", "gnu-netcat", "go", "gparted", "gradle", "grub",
+    "gst-plugins-good", "hashcat", "haveged", "helix", "htop", "httpie", "hydra", "hyprland",
+    "i3-wm", "imagemagick", "inkscape", "intel-media-driver", "intel-ucode", "iotop", "iperf3",
+    "iproute2", "iptables-nft", "iw", "iwd", "jdk-openjdk", "jq", "julia", "k9s", "kdenlive",
+    "kitty", "kubectl", "lazygit", "ldns", "less", "libreoffice-fresh", "libvirt", "linux-headers",
+    "linux-lts", "linux-zen", "llvm", "lsof", "lvm2", "lz4", "man-db", "man-pages", "mariadb",
+    "masscan", "mdadm", "meld", "meson", "metasploit", "minikube", "mold", "mpv", "mtr", "nano",
+    "ncdu", "neovim", "net-tools", "netcat", "networkmanager", "nfs-utils", "ninja", "nmap",
+    "nodejs", "npm", "ntfs-3g", "nvidia", "nvidia-utils", "nvme-cli", "obs-studio", "openssh",
+    "openvpn", "p7zip", "pacman-contrib", "parted", "perf", "php", "pipewire", "pipewire-pulse",
+    "plasma", "podman", "postgresql", "powertop", "python", "python-pip", "python-virtualenv",
+    "qemu-full", "r", "radare2", "ranger", "redis", "reflector", "restic", "ripgrep", "rsync",
+    "ruby", "rust", "rustup", "samba", "screen", "sddm", "smartmontools", "snapper", "sqlite",
+    "sqlmap", "squashfs-tools", "strace", "sudo", "sway", "syncthing", "sysstat", "tailscale",
+    "tcpdump", "terraform", "thunderbird", "tig", "tldr", "tmux", "tree", "ttf-dejavu",
+    "ttf-jetbrains-mono", "ufw", "unzip", "usbutils", "valgrind", "vim", "virt-manager", "vlc",
+    "vulkan-tools", "wget", "wireguard-tools", "wireless_tools", "wireshark-qt", "xfsprogs",
+    "xorg-server", "yarn", "yt-dlp", "zip", "zoxide", "zram-generator", "zsh", "zstd"
+};
+
+_Static_assert(COUNT_OF(package_catalog) <= PACKAGE_CATALOG_MAX, "catalog bitmap too small");
+_Static_assert(COUNT_OF(config_fields) < 256, "bool_fields holds uint8_t indices");
+
+// In ASCII order, so stepping a character forward never moves the match backwards
+static const char editor_search_chars[] = "-0123456789_abcdefghijklmnopqrstuvwxyz";
+
+// First catalog entry not ordered before the prefix
+static uint16_t archinstallus_catalog_lower_bound(const char* prefix, size_t len) {
+    uint16_t lo = 0;
+    uint16_t hi = COUNT_OF(package_catalog);
+    while(lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if(strncmp(package_catalog[mid], prefix, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
-    app->total_progress = 88;
+    return lo;
+}
+
+static int32_t archinstallus_catalog_find(const char* name) {
+    uint16_t index = archinstallus_catalog_lower_bound(name, strlen(name) + 1);
+    if(index < COUNT_OF(package_catalog) && !strcmp(package_catalog[index], name)) return index;
+    return -1;
+}
+
+static uint16_t archinstallus_editor_row_count(ArchInstallusComplete* app) {
+    return app->editor.tab == EditorTabConfig ? app->editor.bool_count : COUNT_OF(package_catalog);
+}
+
+static void archinstallus_editor_open(ArchInstallusComplete* app) {
+    ConfigEditor* editor = &app->editor;
     
-    // Step 14: System optimization
-    if(!archinstallus_optimize_system(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "Optimization failed");
-        return -1;
+    editor->bool_count = 0;
+    for(size_t i = 0; i < COUNT_OF(config_fields) && editor->bool_count < EDITOR_MAX_FIELDS; i++) {
+        if(config_fields[i].type == ConfigFieldBool) editor->bool_fields[editor->bool_count++] = i;
     }
-    app->total_progress = 95;
     
-    // Step 15: Cleanup
-    if(!archinstallus_cleanup_system(app)) {
-        snprintf(app->error_message, sizeof(app->error_message), "Cleanup failed");
-        return -1;
+    // Mark catalog entries once so drawing never scans custom_packages
+    memset(editor->catalog_marked, 0, sizeof(editor->catalog_marked));
+    for(uint32_t i = 0; i < app->config->package_count; i++) {
+        int32_t index = archinstallus_catalog_find(app->config->custom_packages[i]);
+        if(index >= 0) editor->catalog_marked[index / 8] |= 1 << (index % 8);
     }
-    app->total_progress = 100;
     
-    app->state = STATE_COMPLETE;
-    snprintf(app->status_message, sizeof(app->status_message), "Installation complete!");
+    editor->searching = false;
+    editor->prefix_len = 0;
+    editor->repeat_count = 0;
+    editor->error[0] = '\0';
+    editor->frame_us_max = 0;
+    editor->open = true;
+}
+
+// Edits are held to the same rules as the SD config. The parser lives on the heap, since this
+// runs on the GUI thread's small stack
+static bool archinstallus_editor_validate(ArchInstallusComplete* app) {
+    ConfigParser* parser = malloc(sizeof(ConfigParser));
+    memset(parser, 0, sizeof(ConfigParser));
+    parser->config = app->config;
+    bool ok = archinstallus_config_validate(parser);
+    if(!ok) snprintf(app->editor.error, sizeof(app->editor.error), "%s", parser->error);
+    free(parser);
+    return ok;
+}
+
+static void archinstallus_editor_close(ArchInstallusComplete* app) {
+    app->editor.open = false;
+    // Toggles that fail validation are undone, so this only catches what slipped past them
+    if(app->config_valid && !archinstallus_editor_validate(app)) {
+        app->config_valid = false;
+        snprintf(app->error_message, sizeof(app->error_message), "editor: %s", app->editor.error);
+        snprintf(app->status_message, sizeof(app->status_message), "Config: %s", app->editor.error);
+    }
+    archinstallus_log(app, "Editor: %lu packages, frame max %luus", app->config->package_count, app->editor.frame_us_max);
+}
+
+static void archinstallus_editor_select(ArchInstallusComplete* app, int32_t row) {
+    ConfigEditor* editor = &app->editor;
+    int32_t count = archinstallus_editor_row_count(app);
+    if(count == 0) return;
+    if(row < 0) row = 0;
+    if(row >= count) row = count - 1;
     
-    return 0;
+    // Scroll just enough to keep the selection in the visible window
+    uint16_t* top = &editor->top[editor->tab];
+    editor->selected[editor->tab] = row;
+    if(row < *top) {
+        *top = row;
+    } else if(row >= *top + EDITOR_VISIBLE_ROWS) {
+        *top = row - EDITOR_VISIBLE_ROWS + 1;
+    }
+}
+
+// Held keys repeat every ~150 ms; the step widens the longer the key is held
+static int32_t archinstallus_editor_step(ConfigEditor* editor) {
+    if(editor->repeat_count < EDITOR_ACCEL_REPEATS) return 1;
+    if(editor->repeat_count < 2 * EDITOR_ACCEL_REPEATS) return EDITOR_VISIBLE_ROWS;
+    return 4 * EDITOR_VISIBLE_ROWS;
+}
+
+static void archinstallus_editor_toggle(ArchInstallusComplete* app) {
+    ConfigEditor* editor = &app->editor;
+    uint16_t row = editor->selected[editor->tab];
+    if(row >= archinstallus_editor_row_count(app)) return;
+    
+    if(editor->tab == EditorTabConfig) {
+        const ConfigField* field = &config_fields[editor->bool_fields[row]];
+        bool* value = (bool*)((uint8_t*)app->config + field->offset);
+        *value = !*value;
+        if(!archinstallus_editor_validate(app)) {
+            *value = !*value;
+            archinstallus_log(app, "Editor: %s.%s unchanged: %s", config_section_names[field->section], field->key, editor->error);
+            notification_message(app->notifications, &sequence_error);
+            return;
+        }
+        archinstallus_log(app, "Editor: %s.%s = %s", config_section_names[field->section], field->key, *value ? "true" : "false");
+        return;
+    }
+    
+    InstallConfig* config = app->config;
+    const char* name = package_catalog[row];
+    uint8_t bit = 1 << (row % 8);
+    if(editor->catalog_marked[row / 8] & bit) {
+        for(uint32_t i = 0; i < config->package_count; i++) {
+            if(strcmp(config->custom_packages[i], name)) continue;
+            // pacstrap doesn't care about order, so the last entry fills the gap
+            config->package_count--;
+            if(i != config->package_count) {
+                memcpy(config->custom_packages[i], config->custom_packages[config->package_count], sizeof(config->custom_packages[0]));
+            }
+            break;
+        }
+        editor->catalog_marked[row / 8] &= ~bit;
+    } else {
+        if(config->package_count >= MAX_PACKAGES) return;
+        snprintf(config->custom_packages[config->package_count++], sizeof(config->custom_packages[0]), "%s", name);
+        editor->catalog_marked[row / 8] |= bit;
+    }
+}
+
+// Jump to the first package matching the prefix typed so far
+static void archinstallus_editor_search_apply(ArchInstallusComplete* app) {
+    ConfigEditor* editor = &app->editor;
+    editor->prefix[editor->prefix_len] = '\0';
+    archinstallus_editor_select(app, archinstallus_catalog_lower_bound(editor->prefix, editor->prefix_len));
+}
+
+static void archinstallus_editor_search_cycle(ConfigEditor* editor, int32_t delta) {
+    const size_t count = sizeof(editor_search_chars) - 1;
+    char* last = &editor->prefix[editor->prefix_len - 1];
+    const char* pos = strchr(editor_search_chars, *last);
+    size_t index = pos ? (size_t)(pos - editor_search_chars) : 0;
+    *last = editor_search_chars[(index + count + delta) % count];
+}
+
+// Guess the next character from the selected row; Up/Down then adjust it
+static void archinstallus_editor_search_extend(ArchInstallusComplete* app) {
+    ConfigEditor* editor = &app->editor;
+    if(editor->prefix_len >= EDITOR_PREFIX_LEN - 1) return;
+    const char* name = package_catalog[editor->selected[EditorTabPackages]];
+    char next = editor_search_chars[0];
+    if(!strncmp(name, editor->prefix, editor->prefix_len) && name[editor->prefix_len]) next = name[editor->prefix_len];
+    editor->prefix[editor->prefix_len++] = next;
+}
+
+static void archinstallus_editor_search_input(ArchInstallusComplete* app, InputEvent* event) {
+    ConfigEditor* editor = &app->editor;
+    bool repeatable = event->type == InputTypePress || event->type == InputTypeRepeat;
+    
+    if(repeatable && (event->key == InputKeyUp || event->key == InputKeyDown)) {
+        archinstallus_editor_search_cycle(editor, event->key == InputKeyUp ? -1 : 1);
+    } else if(event->type != InputTypeShort) {
+        return;
+    } else if(event->key == InputKeyRight) {
+        archinstallus_editor_search_extend(app);
+    } else if(event->key == InputKeyLeft) {
+        if(--editor->prefix_len == 0) editor->searching = false;
+    } else if(event->key == InputKeyOk || event->key == InputKeyBack) {
+        editor->searching = false;
+        return;
+    } else {
+        return;
+    }
+    if(editor->searching) archinstallus_editor_search_apply(app);
+}
+
+static void archinstallus_editor_input(ArchInstallusComplete* app, InputEvent* event) {
+    ConfigEditor* editor = &app->editor;
+    
+    if(event->type == InputTypePress) {
+        editor->repeat_count = 0;
+        editor->error[0] = '\0';
+    } else if(event->type == InputTypeRepeat && editor->repeat_count < UINT16_MAX) {
+        editor->repeat_count++;
+    }
+    
+    if(editor->searching) {
+        archinstallus_editor_search_input(app, event);
+        view_port_update(app->view_port);
+        return;
+    }
+    
+    switch(event->key) {
+        case InputKeyUp:
+        case InputKeyDown:
+            if(event->type == InputTypePress || event->type == InputTypeRepeat) {
+                int32_t step = archinstallus_editor_step(editor);
+                archinstallus_editor_select(app, editor->selected[editor->tab] + (event->key == InputKeyUp ? -step : step));
+            }
+            break;
+            
+        case InputKeyOk:
+            if(event->type == InputTypeShort) {
+                archinstallus_editor_toggle(app);
+            } else if(event->type == InputTypeLong && editor->tab == EditorTabPackages) {
+                // Start from the selected row's first letter
+                editor->searching = true;
+                editor->prefix_len = 0;
+                archinstallus_editor_search_extend(app);
+                archinstallus_editor_search_apply(app);
+            }
+            break;
+            
+        case InputKeyLeft:
+        case InputKeyRight:
+            if(event->type == InputTypeShort) {
+                editor->tab = (editor->tab + 1) % EditorTabCount;
+            }
+            break;
+            
+        case InputKeyBack:
+            if(event->type == InputTypeShort) archinstallus_editor_close(app);
+            break;
+            
+        default:
+            break;
+    }
+    view_port_update(app->view_port);
+}
+
+static void archinstallus_draw_editor(Canvas* canvas, ArchInstallusComplete* app) {
+    ConfigEditor* editor = &app->editor;
+    uint32_t start = DWT->CYCCNT;
+    uint16_t count = archinstallus_editor_row_count(app);
+    uint16_t selected = editor->selected[editor->tab];
+    uint16_t top = editor->top[editor->tab];
+    char line[40];
+    
+    canvas_clear(canvas);
+    canvas_set_color(canvas, ColorBlack);
+    canvas_draw_box(canvas, 0, 0, 128, 64);
+    canvas_set_color(canvas, ColorWhite);
+    canvas_set_font(canvas, FontSecondary);
+    
+    // Header: tab and position, the search prefix being typed, or why a toggle was refused
+    if(editor->error[0]) {
+        snprintf(line, sizeof(line), "%s", editor->error);
+    } else if(editor->searching) {
+        snprintf(line, sizeof(line), "Find: %s_", editor->prefix);
+    } else if(editor->tab == EditorTabConfig && count > 0) {
+        const ConfigField* field = &config_fields[editor->bool_fields[selected]];
+        snprintf(line, sizeof(line), "Config %u/%u [%s]", selected + 1, count, config_section_names[field->section]);
+    } else {
+        snprintf(line, sizeof(line), "Packages %u/%u (%lu)", selected + 1, count, app->config->package_count);
+    }
+    canvas_draw_str(canvas, 2, 8, line);
+    if(app->debug_overlay) {
+        snprintf(line, sizeof(line), "%luus", editor->frame_us);
+        canvas_draw_str_aligned(canvas, 126, 8, AlignRight, AlignBottom, line);
+    }
+    canvas_draw_line(canvas, 0, 10, 127, 10);
+    
+    // Only the visible window is drawn, whatever the row count
+    for(uint16_t i = 0; i < EDITOR_VISIBLE_ROWS && top + i < count; i++) {
+        uint16_t row = top + i;
+        int32_t y = 11 + i * EDITOR_ROW_HEIGHT;
+        const char* label;
+        bool checked;
+        if(editor->tab == EditorTabConfig) {
+            const ConfigField* field = &config_fields[editor->bool_fields[row]];
+            label = field->key;
+            checked = *(const bool*)((const uint8_t*)app->config + field->offset);
+        } else {
+            label = package_catalog[row];
+            checked = editor->catalog_marked[row / 8] & (1 << (row % 8));
+        }
+        
+        if(row == selected) {
+            canvas_draw_box(canvas, 0, y, 123, EDITOR_ROW_HEIGHT);
+            canvas_set_color(canvas, ColorBlack);
+        }
+        canvas_draw_frame(canvas, 2, y + 2, 7, 7);
+        if(checked) canvas_draw_box(canvas, 4, y + 4, 3, 3);
+        canvas_draw_str(canvas, 12, y + 8, label);
+        canvas_set_color(canvas, ColorWhite);
+    }
+    
+    // Scrollbar
+    if(count > EDITOR_VISIBLE_ROWS) {
+        uint16_t track = EDITOR_VISIBLE_ROWS * EDITOR_ROW_HEIGHT;
+        uint16_t thumb = MAX(track * EDITOR_VISIBLE_ROWS / count, 3);
+        uint16_t offset = (track - thumb) * top / (count - EDITOR_VISIBLE_ROWS);
+        canvas_draw_box(canvas, 125, 11 + offset, 2, thumb);
+    }
+    
+    editor->frame_us = (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond();
+    if(editor->frame_us > editor->frame_us_max) editor->frame_us_max = editor->frame_us;
 }
+#endif
 
 // Professional UI Drawing
 static void archinstallus_draw_complete(Canvas* canvas, void* ctx) {
     ArchInstallusComplete* app = ctx;
     
+    app->gui_thread_id = furi_thread_get_current_id();
+#if ARCHINSTALLUS_WITH_EDITOR
+    if(app->editor.open) {
+        archinstallus_draw_editor(canvas, app);
+        return;
+    }
+#endif
+    
     canvas_clear(canvas);
     canvas_set_color(canvas, ColorBlack);
     canvas_draw_box(canvas, 0, 0, 128, 64);
@@ -693,7 +4399,7 @@ static void archinstallus_draw_complete(Canvas* canvas, void* ctx) {
     // Title
     canvas_draw_str(canvas, 2, 10, "ArchInstallus Complete");
     canvas_set_font(canvas, FontSecondary);
-    canvas_draw_str(canvas, 2, 20, "v" APP_VERSION);
+    canvas_draw_str(canvas, 2, 20, "v" APP_VERSION " " ARCHINSTALLUS_VARIANT);
     
     // Current state
     canvas_set_font(canvas, FontPrimary);
@@ -721,7 +4427,11 @@ static void archinstallus_draw_complete(Canvas* canvas, void* ctx) {
     
     // Controls
     if(app->state == STATE_IDLE) {
+#if ARCHINSTALLUS_WITH_EDITOR
+        canvas_draw_str(canvas, 2, 58, "OK=Start Right=Edit");
+#else
         canvas_draw_str(canvas, 2, 58, "OK=Start  Back=Exit");
+#endif
     } else if(app->state == STATE_COMPLETE) {
         canvas_draw_str(canvas, 2, 58, "Installation Complete!");
     } else if(app->state == STATE_ERROR) {
@@ -730,6 +4440,24 @@ static void archinstallus_draw_complete(Canvas* canvas, void* ctx) {
     } else {
         canvas_draw_str(canvas, 2, 58, "Back=Stop");
     }
+    
+    // Debug overlay replaces the lower half
+    if(app->debug_overlay) {
+        MemoryStats stats;
+        archinstallus_memory_sample(app, &stats);
+        
+        canvas_set_color(canvas, ColorBlack);
+        canvas_draw_box(canvas, 0, 34, 128, 30);
+        canvas_set_color(canvas, ColorWhite);
+        canvas_set_font(canvas, FontSecondary);
+        char line[32];
+        snprintf(line, sizeof(line), "Heap %uK min %uK", stats.free_heap / 1024, stats.min_free_heap / 1024);
+        canvas_draw_str(canvas, 2, 42, line);
+        snprintf(line, sizeof(line), "Max block %uK", stats.max_free_block / 1024);
+        canvas_draw_str(canvas, 2, 52, line);
+        snprintf(line, sizeof(line), "Stack gui %lu inst %lu", stats.gui_stack, stats.installer_stack);
+        canvas_draw_str(canvas, 2, 62, line);
+    }
 }
 
 // Professional Input Handling
@@ -737,25 +4465,53 @@ static void archinstallus_input_complete(InputEvent* input_event, void* ctx) {
     ArchInstallusComplete* app = ctx;
     furi_assert(app);
     
+#if ARCHINSTALLUS_WITH_EDITOR
+    if(app->editor.open) {
+        archinstallus_editor_input(app, input_event);
+        return;
+    }
+    
+    // Opened on release so the same key doesn't also reach the editor
+    if(input_event->type == InputTypeShort && input_event->key == InputKeyRight) {
+        if(app->state == STATE_IDLE && !app->running) {
+            archinstallus_editor_open(app);
+            view_port_update(app->view_port);
+        }
+        return;
+    }
+#endif
+    
     if(input_event->type == InputTypePress) {
         switch(input_event->key) {
             case InputKeyOk:
-                if(app->state == STATE_IDLE && !app->running) {
+                // Installing the defaults instead of what the file asked for would wipe the wrong setup
+                if(app->state == STATE_IDLE && !app->running && !app->config_valid) {
+                    archinstallus_log(app, "Start refused: %s", app->error_message);
+                    notification_message(app->notifications, &sequence_error);
+                } else if(app->state == STATE_IDLE && !app->running) {
                     app->running = true;
                     app->paused = false;
                     app->start_time = furi_get_tick();
                     
+                    // Previous run has finished by now (state is back to idle)
+                    if(app->installer_thread) {
+                        furi_thread_join(app->installer_thread);
+                        furi_thread_free(app->installer_thread);
+                    }
+                    
                     // Start installation in background
-                    FuriThread* thread = furi_thread_alloc();
-                    furi_thread_set_name(thread, "ArchInstallusComplete");
-                    furi_thread_set_callback(thread, archinstallus_perform_installation);
-                    furi_thread_set_context(thread, app);
-                    furi_thread_start(thread);
+                    app->installer_thread = furi_thread_alloc_ex(
+                        "ArchInstallusComplete", INSTALLER_STACK_SIZE, archinstallus_perform_installation, app);
+                    furi_thread_start(app->installer_thread);
                     
                     notification_message(app->notifications, &sequence_single_vibro);
                 }
                 break;
                 
+            case InputKeyLeft:
+                app->debug_overlay = !app->debug_overlay;
+                break;
+                
             case InputKeyBack:
                 if(app->running && app->state != STATE_COMPLETE && app->state != STATE_ERROR) {
                     app->paused = !app->paused;
@@ -780,7 +4536,7 @@ static void archinstallus_input_complete(InputEvent* input_event, void* ctx) {
 int32_t archinstallus_main(void* p) {
     UNUSED(p);
     
-    FURI_LOG_I(TAG, "Starting COMPLETE ArchInstallus v%s", APP_VERSION);
+    FURI_LOG_I(TAG, "Starting COMPLETE ArchInstallus v%s (%s)", APP_VERSION, ARCHINSTALLUS_VARIANT);
     
     // Allocate COMPLETE application
     ArchInstallusComplete* app = malloc(sizeof(ArchInstallusComplete));
@@ -791,6 +4547,7 @@ int32_t archinstallus_main(void* p) {
     
     // Initialize COMPLETE state
     memset(app, 0, sizeof(ArchInstallusComplete));
+    app->config = malloc(sizeof(InstallConfig));
     app->state = STATE_IDLE;
     app->running = false;
     app->paused = false;
@@ -799,20 +4556,6 @@ int32_t archinstallus_main(void* p) {
     app->log_buffer = furi_string_alloc();
     app->log_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
     
-    // Default configuration
-    strcpy(app->config.hostname, "archinstallus");
-    strcpy(app->config.username, "archuser");
-    strcpy(app->config.locale, "en_US.UTF-8");
-    strcpy(app->config.timezone, "UTC");
-    strcpy(app->config.keyboard_layout, "us");
-    strcpy(app->config.kernel_version, "linux");
-    app->config.enable_uefi = true;
-    app->config.create_swap = true;
-    app->config.swap_size = 4ULL * 1024 * 1024 * 1024; // 4GB
-    strcpy(app->config.root_filesystem, "ext4");
-    strcpy(app->config.home_filesystem, "ext4");
-    app->config.install_type = INSTALL_FULL;
-    
     // Setup GUI
     app->gui = furi_record_open(RECORD_GUI);
     app->view_port = view_port_alloc();
@@ -826,12 +4569,19 @@ int32_t archinstallus_main(void* p) {
     // Setup storage
     app->storage = furi_record_open(RECORD_STORAGE);
     
-    snprintf(app->status_message, sizeof(app->status_message), "Ready - Press OK to start");
+    // Load configuration from SD
+    // On failure the status line already names the error
+    if(archinstallus_config_load(app)) {
+        snprintf(app->status_message, sizeof(app->status_message), "Ready - Press OK to start");
+    }
     
     // Main event loop
     while(true) {
         furi_delay_ms(100);
         
+        // Redraw so progress and the debug overlay stay live
+        view_port_update(app->view_port);
+        
         // Log current state
         furi_mutex_acquire(app->log_mutex, FuriWaitForever);
         furi_string_cat_printf(app->log_buffer, 
@@ -840,8 +4590,8 @@ int32_t archinstallus_main(void* p) {
                               app->state, app->total_progress, app->status_message);
         furi_mutex_release(app->log_mutex);
         
-        // Update total progress based on state
-        if(app->running && !app->paused) {
+        // Update total progress based on state (fleet mode aggregates its own)
+        if(app->running && !app->paused && !app->fleet) {
             switch(app->state) {
                 case STATE_HARDWARE_DETECT:
                     app->total_progress = 5;
@@ -902,6 +4652,10 @@ int32_t archinstallus_main(void* p) {
     }
     
     // Cleanup (never reached)
+    if(app->installer_thread) {
+        furi_thread_join(app->installer_thread);
+        furi_thread_free(app->installer_thread);
+    }
     notification_message(app->notifications, &sequence_reset_blue);
     view_port_free(app->view_port);
     furi_record_close(RECORD_GUI);
@@ -909,6 +4663,7 @@ int32_t archinstallus_main(void* p) {
     furi_record_close(RECORD_STORAGE);
     furi_string_free(app->log_buffer);
     furi_mutex_free(app->log_mutex);
+    free(app->config);
     free(app);
     
     return 0;
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""
+ArchInstallus CPU plan check
+
+Runs the installer's own CPU probe and plan (archinstallus_cpu_probe and archinstallus_plan_cpu in
+src/archinstallus.c, built for the host like host_check.py does) on /proc/cpuinfo text and prints
+the x86-64 level, vendor, microcode, optimized repository set and kernel it picks. Needs gcc.
+
+Usage:
+  cpu_select.py [--optimized-repos auto|off|x86-64-vN] [--tuned-kernel] [CPUINFO...]
+  cpu_select.py --check
+
+Without files, the local /proc/cpuinfo is used. --check runs every fixture in
+fixtures/cpuinfo/ against fixtures/cpuinfo/expected.txt and exits 1 on any mismatch.
+
+On the device the probe is fed a built-in sample (an i7-11700K) until the target can send its
+/proc/cpuinfo back, and the install log marks the result as such.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+import host_check
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+FIXTURES = os.path.join(TOOLS_DIR, "fixtures", "cpuinfo")
+
+
+def run_probe(binary, files, options=()):
+    result = subprocess.run([binary, "cpu", *options, *files], capture_output=True, text=True)
+    sys.stderr.write(result.stderr)
+    if result.returncode != 0:
+        raise SystemExit(result.returncode)
+    return result.stdout.splitlines()
+
+
+def check(binary):
+    failures = 0
+    with open(os.path.join(FIXTURES, "expected.txt")) as f:
+        rows = [line.split() for line in f if line.strip() and not line.startswith("#")]
+    lines = run_probe(binary, [os.path.join(FIXTURES, row[0]) for row in rows])
+    got_rows = [line.split()[:5] for line in lines if not line.startswith(" ")]
+    for expected, got in zip(rows, got_rows):
+        ok = got == expected
+        failures += not ok
+        print(f"{'ok  ' if ok else 'FAIL'} {got[0]:28} {' '.join(got[1:])}"
+              f"{'' if ok else '  expected ' + ' '.join(expected[1:])}")
+    failures += abs(len(rows) - len(got_rows))
+    print(f"{len(rows) - failures}/{len(rows)} fixtures match")
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Show the CPU plan the installer derives from /proc/cpuinfo")
+    parser.add_argument("files", nargs="*", help="cpuinfo files (default /proc/cpuinfo)")
+    parser.add_argument("--optimized-repos", default="auto", help="[system] optimized_repos value")
+    parser.add_argument("--tuned-kernel", action="store_true", help="[system] tuned_kernel = yes")
+    parser.add_argument("--check", action="store_true", help="verify the fixtures against expected.txt")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="archinstallus-cpu-") as out_dir:
+        binary = host_check.build(out_dir, ["full"])["full"]
+        if args.check:
+            return check(binary)
+
+        options = ["--optimized-repos", args.optimized_repos] + (["--tuned-kernel"] if args.tuned_kernel else [])
+        print("file level vendor microcode repos kernel [aes-ni] [guest]")
+        for line in run_probe(binary, args.files or ["/proc/cpuinfo"], options):
+            print(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,556 @@
+// Host implementation of the furi subset in include/: pthreads, a scaled clock and the local
+// filesystem as the SD card. Waits are shortened by HOST_TIME_SCALE (default 100) and ticks
+// are stretched by the same factor, so the app sees device-like durations in a fraction of the time.
+
+#include <furi.h>
+#include <furi_hal.h>
+#include <gui/gui.h>
+#include <notification/notification_messages.h>
+#include <storage/storage.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// The device is ILP32: the app prints uint32_t with %lu and size_t with %u. On an LP64 host both
+// arrive as at most 64-bit varargs whose low half holds the value, so dropping a single 'l'
+// length modifier reads them correctly.
+static void host_format(char* out, size_t size, const char* format) {
+    size_t len = 0;
+    for(const char* p = format; *p && len + 1 < size; p++) {
+        out[len++] = *p;
+        if(*p != '%') continue;
+        p++;
+        while(*p && strchr("-+ #0123456789.*", *p) && len + 1 < size) out[len++] = *p++;
+        if(p[0] == 'l' && p[1] != 'l') p++;
+        if(!*p) break;
+        if(len + 1 < size) out[len++] = *p;
+    }
+    out[len] = '\0';
+}
+
+int host_vsnprintf(char* buffer, size_t size, const char* format, va_list args) {
+    char host[512];
+    host_format(host, sizeof(host), format);
+    return vsnprintf(buffer, size, host, args);
+}
+
+int host_snprintf(char* buffer, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = host_vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return len;
+}
+
+static pthread_mutex_t host_log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void host_log(char level, const char* tag, const char* format, ...) {
+    UNUSED(tag);
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    host_vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    pthread_mutex_lock(&host_log_lock);
+    printf("[%c] %s\n", level, line);
+    fflush(stdout);
+    pthread_mutex_unlock(&host_log_lock);
+}
+
+// Kernel
+static uint32_t host_time_scale(void) {
+    static uint32_t scale;
+    if(!scale) {
+        const char* env = getenv("HOST_TIME_SCALE");
+        scale = env && atoi(env) > 0 ? (uint32_t)atoi(env) : 100;
+    }
+    return scale;
+}
+
+static uint64_t host_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t furi_get_tick(void) {
+    return (uint32_t)(host_now_us() * host_time_scale() / 1000);
+}
+
+uint32_t furi_kernel_get_tick_frequency(void) {
+    return 1000;
+}
+
+void furi_delay_ms(uint32_t milliseconds) {
+    usleep((useconds_t)((uint64_t)milliseconds * 1000 / host_time_scale()));
+}
+
+// Heap: a roomy device with nothing else running
+size_t memmgr_get_free_heap(void) {
+    return 4 * 1024 * 1024;
+}
+
+size_t memmgr_get_minimum_free_heap(void) {
+    return 4 * 1024 * 1024;
+}
+
+size_t memmgr_heap_get_max_free_block(void) {
+    return 4 * 1024 * 1024;
+}
+
+// Strings
+struct FuriString {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+FuriString* furi_string_alloc(void) {
+    FuriString* string = calloc(1, sizeof(FuriString));
+    string->capacity = 64;
+    string->data = calloc(1, string->capacity);
+    return string;
+}
+
+void furi_string_free(FuriString* string) {
+    free(string->data);
+    free(string);
+}
+
+void furi_string_reset(FuriString* string) {
+    string->size = 0;
+    string->data[0] = '\0';
+}
+
+static void host_string_reserve(FuriString* string, size_t size) {
+    if(size + 1 <= string->capacity) return;
+    while(string->capacity < size + 1) string->capacity *= 2;
+    string->data = realloc(string->data, string->capacity);
+}
+
+int furi_string_cat_vprintf(FuriString* string, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int len = host_vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if(len < 0) return len;
+    host_string_reserve(string, string->size + len);
+    host_vsnprintf(string->data + string->size, len + 1, format, args);
+    string->size += len;
+    return len;
+}
+
+int furi_string_cat_printf(FuriString* string, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = furi_string_cat_vprintf(string, format, args);
+    va_end(args);
+    return len;
+}
+
+int furi_string_printf(FuriString* string, const char* format, ...) {
+    furi_string_reset(string);
+    va_list args;
+    va_start(args, format);
+    int len = furi_string_cat_vprintf(string, format, args);
+    va_end(args);
+    return len;
+}
+
+void furi_string_push_back(FuriString* string, char c) {
+    host_string_reserve(string, string->size + 1);
+    string->data[string->size++] = c;
+    string->data[string->size] = '\0';
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->data;
+}
+
+size_t furi_string_size(const FuriString* string) {
+    return string->size;
+}
+
+// Synchronization
+struct FuriMutex {
+    pthread_mutex_t mutex;
+};
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    FuriMutex* mutex = malloc(sizeof(FuriMutex));
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if(type == FuriMutexTypeRecursive) pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return mutex;
+}
+
+void furi_mutex_free(FuriMutex* mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout) {
+    if(timeout == 0) return pthread_mutex_trylock(&mutex->mutex) ? FuriStatusErrorTimeout : FuriStatusOk;
+    pthread_mutex_lock(&mutex->mutex);
+    return FuriStatusOk;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* mutex) {
+    pthread_mutex_unlock(&mutex->mutex);
+    return FuriStatusOk;
+}
+
+struct FuriSemaphore {
+    sem_t sem;
+};
+
+FuriSemaphore* furi_semaphore_alloc(uint32_t max_count, uint32_t initial_count) {
+    UNUSED(max_count);
+    FuriSemaphore* semaphore = malloc(sizeof(FuriSemaphore));
+    sem_init(&semaphore->sem, 0, initial_count);
+    return semaphore;
+}
+
+void furi_semaphore_free(FuriSemaphore* semaphore) {
+    sem_destroy(&semaphore->sem);
+    free(semaphore);
+}
+
+FuriStatus furi_semaphore_acquire(FuriSemaphore* semaphore, uint32_t timeout) {
+    if(timeout == 0) return sem_trywait(&semaphore->sem) ? FuriStatusErrorTimeout : FuriStatusOk;
+    while(sem_wait(&semaphore->sem) && errno == EINTR) {
+    }
+    return FuriStatusOk;
+}
+
+FuriStatus furi_semaphore_release(FuriSemaphore* semaphore) {
+    sem_post(&semaphore->sem);
+    return FuriStatusOk;
+}
+
+// Threads; host frames are larger than on the device, so every thread gets the same roomy stack.
+// Stacks are painted so furi_thread_get_stack_space can report the deepest use, like FreeRTOS
+#define HOST_THREAD_STACK (512 * 1024)
+#define HOST_STACK_PAINT 0xA5
+#define HOST_MAX_THREADS 64
+
+struct FuriThread {
+    pthread_t thread;
+    FuriThreadCallback callback;
+    void* context;
+    int32_t return_code;
+    bool started;
+    const char* name;
+    uint32_t stack_size; // what the app asked for on the device
+    uint8_t* stack;
+    uint8_t* entry; // frame of host_thread_main; use is measured below it
+};
+
+static FuriThread* host_threads[HOST_MAX_THREADS];
+static pthread_mutex_t host_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void* host_thread_main(void* arg) {
+    FuriThread* thread = arg;
+    thread->entry = __builtin_frame_address(0);
+    thread->return_code = thread->callback(thread->context);
+    return NULL;
+}
+
+FuriThread* furi_thread_alloc_ex(const char* name, uint32_t stack_size, FuriThreadCallback callback, void* context) {
+    FuriThread* thread = calloc(1, sizeof(FuriThread));
+    thread->callback = callback;
+    thread->context = context;
+    thread->name = name;
+    thread->stack_size = stack_size;
+    return thread;
+}
+
+// Bytes below the entry frame that were ever written
+static uint32_t host_thread_stack_used(const FuriThread* thread) {
+    const uint8_t* p = thread->stack;
+    while(p < thread->entry && *p == HOST_STACK_PAINT) p++;
+    return (uint32_t)(thread->entry - p);
+}
+
+void furi_thread_free(FuriThread* thread) {
+    pthread_mutex_lock(&host_threads_lock);
+    for(size_t i = 0; i < HOST_MAX_THREADS; i++) {
+        if(host_threads[i] == thread) host_threads[i] = NULL;
+    }
+    pthread_mutex_unlock(&host_threads_lock);
+    if(thread->stack && thread->entry && host_thread_stack_used(thread) > thread->stack_size) {
+        fprintf(stderr, "host: %s used %u bytes of its %u-byte stack (host frames are larger)\n",
+                thread->name, host_thread_stack_used(thread), thread->stack_size);
+    }
+    free(thread->stack);
+    free(thread);
+}
+
+void furi_thread_start(FuriThread* thread) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(!thread->stack && posix_memalign((void**)&thread->stack, 4096, HOST_THREAD_STACK) != 0) thread->stack = NULL;
+    if(thread->stack) {
+        memset(thread->stack, HOST_STACK_PAINT, HOST_THREAD_STACK);
+        pthread_attr_setstack(&attr, thread->stack, HOST_THREAD_STACK);
+    } else {
+        pthread_attr_setstacksize(&attr, HOST_THREAD_STACK);
+    }
+    pthread_mutex_lock(&host_threads_lock);
+    for(size_t i = 0; i < HOST_MAX_THREADS; i++) {
+        if(!host_threads[i]) {
+            host_threads[i] = thread;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_threads_lock);
+    thread->started = pthread_create(&thread->thread, &attr, host_thread_main, thread) == 0;
+    pthread_attr_destroy(&attr);
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    if(thread->started) pthread_join(thread->thread, NULL);
+    thread->started = false;
+    return true;
+}
+
+int32_t furi_thread_get_return_code(FuriThread* thread) {
+    return thread->return_code;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    return (FuriThreadId)pthread_self();
+}
+
+// Least free stack so far against the size the app asked for; 0 ("unknown" to the app) for the main
+// thread and for a thread that went past its device size
+uint32_t furi_thread_get_stack_space(FuriThreadId thread_id) {
+    uint32_t space = 0;
+    pthread_mutex_lock(&host_threads_lock);
+    for(size_t i = 0; i < HOST_MAX_THREADS; i++) {
+        FuriThread* thread = host_threads[i];
+        if(!thread || !thread->stack || !thread->entry || !pthread_equal(thread->thread, (pthread_t)thread_id)) continue;
+        uint32_t used = host_thread_stack_used(thread);
+        space = used < thread->stack_size ? thread->stack_size - used : 0;
+    }
+    pthread_mutex_unlock(&host_threads_lock);
+    return space;
+}
+
+// Records are opaque handles the shim never dereferences
+static char host_record;
+
+void* furi_record_open(const char* name) {
+    UNUSED(name);
+    return &host_record;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+// HAL
+static DWT_Type host_dwt_registers;
+
+DWT_Type* host_dwt(void) {
+    host_dwt_registers.CYCCNT = (uint32_t)(host_now_us() * 64);
+    return &host_dwt_registers;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 64;
+}
+
+// Fixed epoch so trace file names are reproducible
+uint32_t furi_hal_rtc_get_timestamp(void) {
+    static uint32_t timestamp = 1700000000;
+    return __atomic_fetch_add(&timestamp, 1, __ATOMIC_RELAXED);
+}
+
+// GUI and notifications draw nothing; canvas calls are counted so a frame's work can be compared
+uint32_t host_canvas_calls;
+
+void canvas_clear(Canvas* canvas) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+}
+
+void canvas_set_color(Canvas* canvas, Color color) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(color);
+}
+
+void canvas_set_font(Canvas* canvas, Font font) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(font);
+}
+
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(str);
+}
+
+void canvas_draw_str_aligned(Canvas* canvas, int32_t x, int32_t y, Align horizontal, Align vertical, const char* str) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(horizontal);
+    UNUSED(vertical);
+    UNUSED(str);
+}
+
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(width);
+    UNUSED(height);
+}
+
+void canvas_draw_frame(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(width);
+    UNUSED(height);
+}
+
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    host_canvas_calls++;
+    UNUSED(canvas);
+    UNUSED(x1);
+    UNUSED(y1);
+    UNUSED(x2);
+    UNUSED(y2);
+}
+
+ViewPort* view_port_alloc(void) {
+    return (ViewPort*)&host_record;
+}
+
+void view_port_free(ViewPort* view_port) {
+    UNUSED(view_port);
+}
+
+void view_port_draw_callback_set(ViewPort* view_port, ViewPortDrawCallback callback, void* context) {
+    UNUSED(view_port);
+    UNUSED(callback);
+    UNUSED(context);
+}
+
+void view_port_input_callback_set(ViewPort* view_port, ViewPortInputCallback callback, void* context) {
+    UNUSED(view_port);
+    UNUSED(callback);
+    UNUSED(context);
+}
+
+void view_port_update(ViewPort* view_port) {
+    UNUSED(view_port);
+}
+
+void gui_add_view_port(Gui* gui, ViewPort* view_port, GuiLayer layer) {
+    UNUSED(gui);
+    UNUSED(view_port);
+    UNUSED(layer);
+}
+
+const NotificationSequence sequence_single_vibro = {"single_vibro"};
+const NotificationSequence sequence_success = {"success"};
+const NotificationSequence sequence_error = {"error"};
+const NotificationSequence sequence_reset_blue = {"reset_blue"};
+
+void notification_message(NotificationApp* app, const NotificationSequence* sequence) {
+    UNUSED(app);
+    UNUSED(sequence);
+}
+
+// Storage: paths are already relative to the working directory (see EXT_PATH)
+struct File {
+    FILE* stream;
+};
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    return calloc(1, sizeof(File));
+}
+
+void storage_file_free(File* file) {
+    free(file);
+}
+
+bool storage_file_open(File* file, const char* path, FS_AccessMode access_mode, FS_OpenMode open_mode) {
+    const char* mode = "rb";
+    if(access_mode & FSAM_WRITE) {
+        mode = open_mode == FSOM_OPEN_APPEND ? "ab" : (access_mode & FSAM_READ) ? "w+b" : "wb";
+    }
+    file->stream = fopen(path, mode);
+    return file->stream != NULL;
+}
+
+bool storage_file_close(File* file) {
+    if(file->stream) fclose(file->stream);
+    file->stream = NULL;
+    return true;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    return fread(buff, 1, bytes_to_read, file->stream);
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    return fwrite(buff, 1, bytes_to_write, file->stream);
+}
+
+bool storage_file_exists(Storage* storage, const char* path) {
+    UNUSED(storage);
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+bool storage_simply_mkdir(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char partial[256];
+    snprintf(partial, sizeof(partial), "%s", path);
+    for(char* slash = strchr(partial + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(partial, 0755);
+        *slash = '/';
+    }
+    return mkdir(partial, 0755) == 0 || errno == EEXIST;
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    UNUSED(storage);
+    struct stat st;
+    if(stat(path, &st)) return FSE_NOT_EXIST;
+    fileinfo->flags = S_ISDIR(st.st_mode) ? 1 : 0;
+    fileinfo->size = (uint64_t)st.st_size;
+    return FSE_OK;
+}
+
+FS_Error storage_common_timestamp(Storage* storage, const char* path, uint32_t* timestamp) {
+    UNUSED(storage);
+    struct stat st;
+    if(stat(path, &st)) return FSE_NOT_EXIST;
+    *timestamp = (uint32_t)st.st_mtime;
+    return FSE_OK;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    return remove(path) ? FSE_INTERNAL : FSE_OK;
+}
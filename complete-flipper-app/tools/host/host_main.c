@@ -0,0 +1,368 @@
+// Host driver for archinstallus.c: builds the app source against the stubs in include/ and runs
+// its config loader, planners and pipeline from the command line. tools/host_check.py builds it
+// once per variant and compares the output with the golden files in tools/fixtures/host/.
+//
+//   archinstallus_host config            load the SD config (ext/apps_data/archinstallus/) and dump it
+//   archinstallus_host bench-config N    parse the SD config N times and report throughput
+//   archinstallus_host install           press OK, run the installation to the end, then press Back
+//   archinstallus_host editor            toggle config rows and scroll the package list in the editor
+//   archinstallus_host reply FILE        parse chroot session replies, one "<id> <reply>" per line
+//   archinstallus_host cpu [--optimized-repos V] [--tuned-kernel] CPUINFO...
+//                                        run the CPU probe and plan on /proc/cpuinfo files (host paths)
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+// The app formats with the device's ILP32 length modifiers; see host_format() in host_furi.c
+int host_vsnprintf(char* buffer, size_t size, const char* format, va_list args);
+int host_snprintf(char* buffer, size_t size, const char* format, ...);
+#define vsnprintf host_vsnprintf
+#define snprintf host_snprintf
+
+#include "../../src/archinstallus.c"
+
+#undef vsnprintf
+#undef snprintf
+
+static ArchInstallusComplete* host_app_alloc(void) {
+    // Same initial state as archinstallus_main, without the GUI loop
+    ArchInstallusComplete* app = calloc(1, sizeof(ArchInstallusComplete));
+    app->config = malloc(sizeof(InstallConfig));
+    app->state = STATE_IDLE;
+    app->rollback_enabled = true;
+    app->log_buffer = furi_string_alloc();
+    app->log_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    app->notifications = furi_record_open(RECORD_NOTIFICATION);
+    app->storage = furi_record_open(RECORD_STORAGE);
+    return app;
+}
+
+static void host_app_free(ArchInstallusComplete* app) {
+    furi_string_free(app->log_buffer);
+    furi_mutex_free(app->log_mutex);
+    free(app->config);
+    free(app);
+}
+
+static void host_press(ArchInstallusComplete* app, InputKey key, InputType type) {
+    InputEvent event = {.key = key, .type = type};
+    archinstallus_input_complete(&event, app);
+}
+
+#if ARCHINSTALLUS_WITH_EDITOR
+// Press, short and release, as the input service reports a tap
+static void host_tap(ArchInstallusComplete* app, InputKey key) {
+    host_press(app, key, InputTypePress);
+    host_press(app, key, InputTypeShort);
+    host_press(app, key, InputTypeRelease);
+}
+#endif
+
+// App log without the "[ticks] " prefix, which differs on every run
+static void host_print_log(ArchInstallusComplete* app) {
+    const char* line = furi_string_get_cstr(app->log_buffer);
+    while(*line) {
+        size_t len = strcspn(line, "\n");
+        const char* text = line;
+        if(*text == '[') {
+            const char* close = strchr(text, ']');
+            if(close && close < line + len && close[1] == ' ') text = close + 2;
+        }
+        printf("log: %.*s\n", (int)(len - (text - line)), text);
+        line += len;
+        if(*line) line++;
+    }
+}
+
+static void host_print_config(const InstallConfig* config) {
+    for(size_t i = 0; i < COUNT_OF(config_fields); i++) {
+        const ConfigField* field = &config_fields[i];
+        const uint8_t* value = (const uint8_t*)config + field->offset;
+        printf("%s.%s = ", config_section_names[field->section], field->key);
+        switch(field->type) {
+        case ConfigFieldString:
+            printf("%s\n", (const char*)value);
+            break;
+        case ConfigFieldBool:
+            printf("%s\n", *(const bool*)value ? "true" : "false");
+            break;
+        case ConfigFieldSize:
+            printf("%llu\n", (unsigned long long)*(const uint64_t*)value);
+            break;
+        case ConfigFieldUint:
+            printf("%u\n", *(const uint32_t*)value);
+            break;
+        case ConfigFieldInstallType:
+            printf("%s\n", install_type_names[*(const InstallType*)value]);
+            break;
+        }
+    }
+    printf("packages (%u):", config->package_count);
+    for(uint32_t i = 0; i < config->package_count; i++) printf(" %s", config->custom_packages[i]);
+    printf("\n");
+    for(uint32_t i = 0; i < config->mirror_count; i++) printf("mirror: %s\n", config->mirrors[i]);
+    for(uint32_t i = 0; i < config->fleet_target_count; i++) {
+        printf("target: %s = %s\n", config->fleet_targets[i], config->fleet_target_disks[i]);
+    }
+}
+
+static int host_config(void) {
+    ArchInstallusComplete* app = host_app_alloc();
+    bool ok = archinstallus_config_load(app);
+    printf("load: %s\n", ok ? "ok" : "error");
+    if(!ok) {
+        printf("error: %s\n", app->error_message);
+        printf("status: %s\n", app->status_message);
+    }
+    host_print_config(app->config);
+    host_app_free(app);
+    return 0;
+}
+
+static int host_bench_config(uint32_t iterations) {
+    InstallConfig* config = malloc(sizeof(InstallConfig));
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    ConfigParser parser;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = true;
+    for(uint32_t i = 0; ok && i < iterations; i++) {
+        ok = archinstallus_config_parse(&parser, storage, config);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if(!ok) {
+        printf("error: %s:%u: %s\n", parser.error_file, parser.error_line, parser.error);
+        free(config);
+        return 1;
+    }
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf(
+        "config: %u files, %u bytes, %u packages; %u parses, %.1f us/parse, %.1f MB/s\n",
+        parser.source_count,
+        parser.bytes,
+        config->package_count,
+        iterations,
+        seconds * 1e6 / iterations,
+        (double)parser.bytes * iterations / seconds / 1e6);
+    free(config);
+    return 0;
+}
+
+static int host_install(void) {
+    ArchInstallusComplete* app = host_app_alloc();
+    if(archinstallus_config_load(app)) {
+        snprintf(app->status_message, sizeof(app->status_message), "Ready - Press OK to start");
+    }
+
+    host_press(app, InputKeyOk, InputTypePress);
+    if(!app->running) {
+        printf("start: refused\n");
+    } else {
+        furi_thread_join(app->installer_thread);
+        printf("start: ok\n");
+        printf("result: %d\n", furi_thread_get_return_code(app->installer_thread));
+        printf("state: %d\n", app->state);
+        printf("error: %s\n", app->error_message);
+        furi_thread_free(app->installer_thread);
+        app->installer_thread = NULL;
+        printf("status: %s\n", app->status_message);
+        // Back after the run ends should return to idle so another run can start
+        host_press(app, InputKeyBack, InputTypePress);
+        printf("back: state %d, running %d\n", app->state, app->running);
+    }
+    printf("status: %s\n", app->status_message);
+    host_print_log(app);
+    host_app_free(app);
+    return 0;
+}
+
+#if ARCHINSTALLUS_WITH_EDITOR
+extern uint32_t host_canvas_calls;
+
+// Per-frame work of the editor: canvas calls (the same on the device) and editor time on this host
+typedef struct {
+    uint32_t frames;
+    uint32_t calls_min;
+    uint32_t calls_max;
+    uint64_t us_total;
+} HostFrames;
+
+static void host_frame(ArchInstallusComplete* app, HostFrames* frames) {
+    uint32_t calls = host_canvas_calls;
+    archinstallus_draw_complete(NULL, app);
+    calls = host_canvas_calls - calls;
+    if(!frames->frames || calls < frames->calls_min) frames->calls_min = calls;
+    if(calls > frames->calls_max) frames->calls_max = calls;
+    frames->us_total += app->editor.frame_us;
+    frames->frames++;
+}
+
+// Move the selection to a config row by key, the way a user would
+static void host_editor_toggle_key(ArchInstallusComplete* app, const char* key, HostFrames* frames) {
+    ConfigEditor* editor = &app->editor;
+    uint16_t row = 0;
+    while(row < editor->bool_count && strcmp(config_fields[editor->bool_fields[row]].key, key)) row++;
+    while(editor->selected[EditorTabConfig] < row) {
+        host_tap(app, InputKeyDown);
+        host_frame(app, frames);
+    }
+    while(editor->selected[EditorTabConfig] > row) {
+        host_tap(app, InputKeyUp);
+        host_frame(app, frames);
+    }
+    const ConfigField* field = &config_fields[editor->bool_fields[row]];
+    host_tap(app, InputKeyOk);
+    host_frame(app, frames);
+    printf(
+        "toggle %s: %s%s%s\n",
+        key,
+        *(const bool*)((const uint8_t*)app->config + field->offset) ? "true" : "false",
+        editor->error[0] ? ", refused: " : "",
+        editor->error);
+}
+
+static int host_editor(void) {
+    ArchInstallusComplete* app = host_app_alloc();
+    HostFrames frames = {0};
+    ConfigEditor* editor = &app->editor;
+    if(archinstallus_config_load(app)) {
+        printf("load: ok\n");
+        snprintf(app->status_message, sizeof(app->status_message), "Ready - Press OK to start");
+    } else {
+        printf("load: error\n");
+    }
+
+    host_tap(app, InputKeyRight);
+    host_frame(app, &frames);
+    printf("open: %d, %u config rows, %u packages\n", editor->open, editor->bool_count, (unsigned)COUNT_OF(package_catalog));
+    host_editor_toggle_key(app, "encryption", &frames);
+    host_editor_toggle_key(app, "dev_tools", &frames);
+
+    // Hold Down through the whole catalog; the step widens with the repeat count
+    host_tap(app, InputKeyLeft);
+    host_press(app, InputKeyDown, InputTypePress);
+    host_frame(app, &frames);
+    for(uint32_t i = 1; (size_t)editor->selected[EditorTabPackages] + 1 < COUNT_OF(package_catalog); i++) {
+        host_press(app, InputKeyDown, InputTypeRepeat);
+        host_frame(app, &frames);
+        if(i % 6 == 0) {
+            uint16_t row = editor->selected[EditorTabPackages];
+            printf("repeat %u: row %u, top %u, %s\n", i, row, editor->top[EditorTabPackages], package_catalog[row]);
+        }
+    }
+    host_press(app, InputKeyDown, InputTypeRelease);
+    uint16_t row = editor->selected[EditorTabPackages];
+    printf("end: row %u, top %u, %s\n", row, editor->top[EditorTabPackages], package_catalog[row]);
+    host_tap(app, InputKeyOk);
+    host_frame(app, &frames);
+    printf("packages: %u\n", app->config->package_count);
+
+    host_tap(app, InputKeyBack);
+    printf(
+        "frames: %u, canvas calls %u-%u, editor %.1f us/frame, max %u us\n",
+        frames.frames,
+        frames.calls_min,
+        frames.calls_max,
+        (double)frames.us_total / frames.frames,
+        editor->frame_us_max);
+    printf("close: open %d, valid %d\n", editor->open, app->config_valid);
+    printf("status: %s\n", app->status_message);
+    host_print_log(app);
+    host_app_free(app);
+    return 0;
+}
+#endif
+
+static int host_reply(const char* name) {
+    char path[128];
+    snprintf(path, sizeof(path), APP_DATA_DIR "/%s", name);
+    FILE* file = fopen(path, "r");
+    if(!file) {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+    char line[128];
+    while(fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+        char* reply;
+        uint32_t id = strtoul(line, &reply, 10);
+        if(*reply == ' ') reply++;
+        int32_t status;
+        uint64_t busy_us;
+        if(archinstallus_chroot_parse_reply(reply, id, &status, &busy_us)) {
+            printf("%u \"%s\": status %d, %llu us\n", id, reply, status, (unsigned long long)busy_us);
+        } else {
+            printf("%u \"%s\": rejected\n", id, reply);
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+// One line per file, "<file> <level> <vendor> <microcode> <repos> <kernel> [aes-ni] [guest]", then the
+// repository set when one is picked; tools/cpu_select.py checks the first five columns
+static int host_cpu(int argc, char** argv) {
+    InstallConfig* config = malloc(sizeof(InstallConfig));
+    archinstallus_config_defaults(config);
+    int status = 0;
+    for(int i = 0; i < argc; i++) {
+        if(!strcmp(argv[i], "--optimized-repos") && i + 1 < argc) {
+            snprintf(config->optimized_repos, sizeof(config->optimized_repos), "%s", argv[++i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--tuned-kernel")) {
+            config->tuned_kernel = true;
+            continue;
+        }
+        FILE* file = fopen(argv[i], "r");
+        if(!file) {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        char* cpuinfo = calloc(1, 64 * 1024);
+        fread(cpuinfo, 1, 64 * 1024 - 1, file);
+        fclose(file);
+
+        HardwareInfo hw = {0};
+        CpuPlan plan;
+        archinstallus_cpu_probe(&hw, cpuinfo);
+        archinstallus_plan_cpu(&hw, config, &plan);
+        free(cpuinfo);
+        const char* name = strrchr(argv[i], '/');
+        printf(
+            "%s %s %s %s %s %s%s%s\n",
+            name ? name + 1 : argv[i],
+            cpu_level_names[hw.cpu_level],
+            hw.cpu_vendor == CpuVendorIntel ? "intel" : hw.cpu_vendor == CpuVendorAmd ? "amd" : "unknown",
+            plan.microcode ? plan.microcode : "none",
+            plan.repos ? cpu_level_names[plan.repos->level] : "generic",
+            plan.kernel,
+            hw.aes_ni ? " aes-ni" : "",
+            hw.hypervisor ? " guest" : "");
+        if(plan.repos) {
+            printf("  repos:");
+            for(size_t r = 0; r < COUNT_OF(plan.repos->repos); r++) printf(" %s", plan.repos->repos[r]);
+            printf(" (Architecture = %s)\n", plan.repos->arch);
+        }
+    }
+    free(config);
+    return status;
+}
+
+int main(int argc, char** argv) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    if(argc >= 2 && !strcmp(argv[1], "config")) return host_config();
+    if(argc >= 3 && !strcmp(argv[1], "bench-config")) return host_bench_config((uint32_t)atoi(argv[2]));
+    if(argc >= 2 && !strcmp(argv[1], "install")) return host_install();
+    if(argc >= 3 && !strcmp(argv[1], "reply")) return host_reply(argv[2]);
+    if(argc >= 3 && !strcmp(argv[1], "cpu")) return host_cpu(argc - 2, argv + 2);
+#if ARCHINSTALLUS_WITH_EDITOR
+    if(argc >= 2 && !strcmp(argv[1], "editor")) return host_editor();
+#endif
+    fprintf(stderr, "usage: %s config | bench-config N | install | editor | reply FILE | cpu CPUINFO...\n", argv[0]);
+    return 2;
+}
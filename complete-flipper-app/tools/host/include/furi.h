@@ -0,0 +1,88 @@
+// Host stand-in for the parts of the furi API the app uses; implemented in ../host_furi.c
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNUSED(x) (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define furi_assert(x) (void)(x)
+#define furi_check(x) (void)(x)
+
+// SD card root, relative to the working directory of the host binary
+#define EXT_PATH(path) "ext/" path
+
+void host_log(char level, const char* tag, const char* format, ...);
+#define FURI_LOG_E(tag, format, ...) host_log('E', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_W(tag, format, ...) host_log('W', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_I(tag, format, ...) host_log('I', tag, format, ##__VA_ARGS__)
+#define FURI_LOG_D(tag, format, ...) host_log('D', tag, format, ##__VA_ARGS__)
+
+#define FuriWaitForever 0xFFFFFFFFU
+
+typedef enum {
+    FuriStatusOk = 0,
+    FuriStatusErrorTimeout = -2,
+} FuriStatus;
+
+// Kernel
+uint32_t furi_get_tick(void);
+uint32_t furi_kernel_get_tick_frequency(void);
+void furi_delay_ms(uint32_t milliseconds);
+
+// Heap
+size_t memmgr_get_free_heap(void);
+size_t memmgr_get_minimum_free_heap(void);
+size_t memmgr_heap_get_max_free_block(void);
+
+// Strings
+typedef struct FuriString FuriString;
+FuriString* furi_string_alloc(void);
+void furi_string_free(FuriString* string);
+void furi_string_reset(FuriString* string);
+int furi_string_printf(FuriString* string, const char* format, ...);
+int furi_string_cat_printf(FuriString* string, const char* format, ...);
+int furi_string_cat_vprintf(FuriString* string, const char* format, va_list args);
+void furi_string_push_back(FuriString* string, char c);
+const char* furi_string_get_cstr(const FuriString* string);
+size_t furi_string_size(const FuriString* string);
+
+// Synchronization
+typedef enum {
+    FuriMutexTypeNormal,
+    FuriMutexTypeRecursive,
+} FuriMutexType;
+typedef struct FuriMutex FuriMutex;
+FuriMutex* furi_mutex_alloc(FuriMutexType type);
+void furi_mutex_free(FuriMutex* mutex);
+FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout);
+FuriStatus furi_mutex_release(FuriMutex* mutex);
+
+typedef struct FuriSemaphore FuriSemaphore;
+FuriSemaphore* furi_semaphore_alloc(uint32_t max_count, uint32_t initial_count);
+void furi_semaphore_free(FuriSemaphore* semaphore);
+FuriStatus furi_semaphore_acquire(FuriSemaphore* semaphore, uint32_t timeout);
+FuriStatus furi_semaphore_release(FuriSemaphore* semaphore);
+
+// Threads
+typedef struct FuriThread FuriThread;
+typedef void* FuriThreadId;
+typedef int32_t (*FuriThreadCallback)(void* context);
+FuriThread* furi_thread_alloc_ex(const char* name, uint32_t stack_size, FuriThreadCallback callback, void* context);
+void furi_thread_free(FuriThread* thread);
+void furi_thread_start(FuriThread* thread);
+bool furi_thread_join(FuriThread* thread);
+int32_t furi_thread_get_return_code(FuriThread* thread);
+FuriThreadId furi_thread_get_current_id(void);
+uint32_t furi_thread_get_stack_space(FuriThreadId thread_id);
+
+// Records
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
@@ -0,0 +1,14 @@
+// Host stand-in for furi_hal: RTC and the Cortex-M cycle counter
+#pragma once
+
+#include <furi.h>
+
+typedef struct {
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+DWT_Type* host_dwt(void);
+#define DWT (host_dwt())
+
+uint32_t furi_hal_rtc_get_timestamp(void);
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
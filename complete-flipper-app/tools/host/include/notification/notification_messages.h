@@ -0,0 +1,15 @@
+#pragma once
+
+#define RECORD_NOTIFICATION "notification"
+
+typedef struct NotificationApp NotificationApp;
+typedef struct {
+    const char* name;
+} NotificationSequence;
+
+extern const NotificationSequence sequence_single_vibro;
+extern const NotificationSequence sequence_success;
+extern const NotificationSequence sequence_error;
+extern const NotificationSequence sequence_reset_blue;
+
+void notification_message(NotificationApp* app, const NotificationSequence* sequence);
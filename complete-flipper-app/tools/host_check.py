@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+ArchInstallus host check
+
+Builds src/archinstallus.c for the host (gcc, against the furi stand-ins in host/include/) once
+per build variant and runs the golden cases in fixtures/host/. Each case directory holds:
+
+  case.txt      commands, one per line:
+                  run <variant> <args>   run the host binary (variant: full, minimal, fleet)
+                  keep <regex>           compare only output lines matching one of these
+                  mask <regex>           replace matches with '#' (timings)
+                  sort                   sort each run's output (for concurrent fleet logs)
+                  copy <from> <to>       copy a file on the SD card before the next run
+  expected.txt  the golden output
+  anything else copied to the SD card (ext/apps_data/archinstallus/), keeping subdirectories
+
+Runs within a case share one SD card, so a later run sees the cache an earlier one wrote.
+
+Usage:
+  host_check.py [CASE...]            run all cases (or the named ones), exit 1 on any mismatch
+  host_check.py --update [CASE...]   rewrite expected.txt from the current output
+  host_check.py --bench [N]          parser throughput on the config-large case
+"""
+
+import argparse
+import difflib
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+HOST_DIR = os.path.join(TOOLS_DIR, "host")
+CASES_DIR = os.path.join(TOOLS_DIR, "fixtures", "host")
+SD_DIR = os.path.join("ext", "apps_data", "archinstallus")
+CASE_FILES = ("case.txt", "expected.txt")
+BENCH_CASE = "config-large"
+
+# application.fam cdefines per variant
+VARIANTS = {
+    "full": [],
+    "minimal": ["-DARCHINSTALLUS_VARIANT_MINIMAL"],
+    "fleet": ["-DARCHINSTALLUS_VARIANT_FLEET"],
+}
+
+
+def build(out_dir, variants=VARIANTS):
+    binaries = {}
+    for variant in variants:
+        defines = VARIANTS[variant]
+        binary = os.path.join(out_dir, f"archinstallus_host_{variant}")
+        cmd = ["gcc", "-std=gnu11", "-O1", "-g", "-Wall", "-Wextra", "-Werror", "-Wno-format", "-I", os.path.join(HOST_DIR, "include"),
+               *defines, os.path.join(HOST_DIR, "host_main.c"), os.path.join(HOST_DIR, "host_furi.c"),
+               "-lpthread", "-o", binary]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            sys.stderr.write(result.stderr)
+            raise SystemExit(f"build failed: {variant}")
+        binaries[variant] = binary
+    return binaries
+
+
+def prepare_sd(case_dir, work_dir):
+    sd = os.path.join(work_dir, SD_DIR)
+    os.makedirs(sd)
+    for root, _, files in os.walk(case_dir):
+        for name in files:
+            rel = os.path.relpath(os.path.join(root, name), case_dir)
+            if rel in CASE_FILES:
+                continue
+            os.makedirs(os.path.dirname(os.path.join(sd, rel)), exist_ok=True)
+            shutil.copy(os.path.join(case_dir, rel), os.path.join(sd, rel))
+
+
+def run_case(name, binaries, work_root):
+    case_dir = os.path.join(CASES_DIR, name)
+    steps, keep, mask, sort = [], [], [], False
+    with open(os.path.join(case_dir, "case.txt")) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            word, _, rest = line.partition(" ")
+            if word in ("run", "copy"):
+                steps.append((word, rest.split()))
+            elif word == "keep":
+                keep.append(re.compile(rest))
+            elif word == "mask":
+                mask.append(re.compile(rest))
+            elif word == "sort":
+                sort = True
+            else:
+                raise SystemExit(f"{name}/case.txt: unknown command {word}")
+
+    work_dir = os.path.join(work_root, name)
+    prepare_sd(case_dir, work_dir)
+    output = []
+    for word, (variant, *args) in steps:
+        if word == "copy":
+            shutil.copy(os.path.join(work_dir, SD_DIR, variant), os.path.join(work_dir, SD_DIR, args[0]))
+            continue
+        result = subprocess.run([binaries[variant], *args], cwd=work_dir, capture_output=True, text=True,
+                                timeout=120)
+        lines = [line for line in result.stdout.splitlines() if not keep or any(k.search(line) for k in keep)]
+        for m in mask:
+            lines = [m.sub("#", line) for line in lines]
+        if result.returncode != 0:
+            lines.append(f"exit {result.returncode}")
+        output.append(f"$ {variant} {' '.join(args)}")
+        output.extend(sorted(lines) if sort else lines)
+    return "\n".join(output) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the host golden tests")
+    parser.add_argument("cases", nargs="*", help="case names (default: all)")
+    parser.add_argument("--update", action="store_true", help="rewrite expected.txt")
+    parser.add_argument("--bench", type=int, nargs="?", const=2000, metavar="N",
+                        help=f"parse the {BENCH_CASE} config N times (default 2000)")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="archinstallus-host-") as work_root:
+        binaries = build(work_root)
+
+        if args.bench:
+            work_dir = os.path.join(work_root, BENCH_CASE)
+            prepare_sd(os.path.join(CASES_DIR, BENCH_CASE), work_dir)
+            return subprocess.run([binaries["full"], "bench-config", str(args.bench)], cwd=work_dir).returncode
+
+        names = args.cases or sorted(d for d in os.listdir(CASES_DIR)
+                                     if os.path.isfile(os.path.join(CASES_DIR, d, "case.txt")))
+        failures = 0
+        for name in names:
+            got = run_case(name, binaries, work_root)
+            expected_path = os.path.join(CASES_DIR, name, "expected.txt")
+            if args.update:
+                with open(expected_path, "w") as f:
+                    f.write(got)
+                print(f"updated {name}")
+                continue
+            with open(expected_path) as f:
+                expected = f.read()
+            if got == expected:
+                print(f"ok   {name}")
+                continue
+            failures += 1
+            print(f"FAIL {name}")
+            sys.stdout.writelines(difflib.unified_diff(expected.splitlines(True), got.splitlines(True),
+                                                       "expected.txt", "output"))
+        if not args.update:
+            print(f"{len(names) - failures}/{len(names)} cases pass")
+        return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,419 @@
+#!/usr/bin/env python3
+"""
+ArchInstallus install benchmark
+
+Runs a reference install pipeline, partitioning through cleanup, against sparse-file loop
+devices and a local package repository, over a matrix of install type, filesystem profile and
+parallelism. Per-stage wall time, bytes written to the loop devices and peak memory go into a
+JSON results file.
+
+The pipeline is written independently of the app. It follows the app's stage order, partition
+layout (without swap) and arrays, and the "full" type installs the app's base_packages, read
+from src/archinstallus.c. The commands themselves are simplified stand-ins: no encryption,
+wipe policy, tuned initramfs or per-target configuration. Use it to catch regressions in the
+storage and package stages, not as a trace of what the app runs.
+
+After mounting, a Throughput stage runs fio on the new home filesystem (sequential write and
+read, 4K random read), so the layouts can be compared: a raid0 or lvm-stripe array should beat
+the single disk on sequential throughput, a raid1 mirror should match it on writes.
+
+Usage:
+  install_bench.py run --repo DIR [--types minimal,full] [--profiles ext4,btrfs]
+                       [--jobs 1,4] [--size-gib 32] [--workdir DIR] [--out results.json]
+                       [--dry-run]
+  install_bench.py compare baseline.json candidate.json [--threshold PCT] [--min-seconds S]
+
+run needs root, fio and an Arch host (pacstrap, arch-chroot, mkinitcpio). --repo is a directory
+made with repo-add holding a database named "bench"; it stands in for the mirrors, so runs
+do not depend on network speed. --dry-run prints the command stream without touching anything.
+compare exits 1 when any stage of a matching run regressed by more than the threshold, in time
+or in fio throughput.
+"""
+
+import argparse
+import itertools
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+APP_SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "archinstallus.c")
+
+
+def read_base_packages(path=APP_SOURCE):
+    """Package names from base_packages[] in the app source."""
+    with open(path) as f:
+        source = f.read()
+    table = re.search(r"base_packages\[\]\s*=\s*\{(.*?)\n\};", source, re.S)
+    names = re.findall(r'\{"([^"]+)"', table.group(1)) if table else []
+    if not names:
+        raise SystemExit(f"no base_packages table in {path}")
+    return names
+
+
+# The app installs base_packages for every type; minimal and developer trim or extend it here
+BASE_PACKAGES = read_base_packages()
+INSTALL_TYPES = {
+    "minimal": ["base", "linux", "linux-firmware", "networkmanager", "sudo"],
+    "full": BASE_PACKAGES,
+    "developer": BASE_PACKAGES + ["gcc", "make", "cmake", "gdb", "ccache", "python"],
+}
+
+# Filesystem profiles: layout and member count as in disk_layout_names
+PROFILES = {
+    "ext4": {"layout": "single", "disks": 1, "fs": "ext4"},
+    "btrfs": {"layout": "single", "disks": 1, "fs": "btrfs"},
+    "xfs": {"layout": "single", "disks": 1, "fs": "xfs"},
+    "ext4-raid0": {"layout": "raid0", "disks": 2, "fs": "ext4"},
+    "ext4-raid1": {"layout": "raid1", "disks": 2, "fs": "ext4"},
+    "xfs-lvm-stripe": {"layout": "lvm-stripe", "disks": 2, "fs": "xfs"},
+}
+
+VG = "archbench"
+MNT = "/mnt/archbench"
+# Commands timed through arch-chroot per command and through one session (archinstallus_chroot_run)
+CHROOT_BENCH_COMMANDS = 20
+# fio jobs on the mounted home filesystem, one after another on one file: (name, rw, block size, iodepth)
+FIO_JOBS = [("seq-write", "write", "1M", 8), ("seq-read", "read", "1M", 8), ("rand-read", "randread", "4k", 32)]
+FIO_SIZE = "1G"
+
+
+def partition_path(disk, number):
+    return f"{disk}p{number}" if disk[-1].isdigit() else f"{disk}{number}"
+
+
+def mkfs(fs, device, label):
+    if fs == "btrfs":
+        return f"mkfs.btrfs -f -L {label} {device}"
+    if fs == "xfs":
+        return f"mkfs.xfs -f -L {label} {device}"
+    return f"mkfs.{fs} -F -L {label} {device}"
+
+
+def plan_devices(profile, disks):
+    """ESP, root and home devices for a profile, like archinstallus_plan_disks."""
+    esp = partition_path(disks[0], 1)
+    if profile["layout"] == "single":
+        return esp, partition_path(disks[0], 2), partition_path(disks[0], 3)
+    return esp, f"/dev/{VG}/root", f"/dev/{VG}/home"
+
+
+def fio_commands(output):
+    """Throughput of the mounted layout; results go to output as fio JSON."""
+    target = f"{MNT}/home/fio.bench"
+    cmd = (f"fio --filename={target} --size={FIO_SIZE} --direct=1 --ioengine=libaio"
+           f" --output-format=json --output={output}")
+    for name, rw, bs, iodepth in FIO_JOBS:
+        cmd += f" --name={name} --stonewall --rw={rw} --bs={bs} --iodepth={iodepth}"
+    return [cmd, f"rm -f {target}"]
+
+
+def read_fio(path):
+    """MiB/s and IOPS per fio job."""
+    with open(path) as f:
+        report = json.load(f)
+    results = {}
+    for job in report["jobs"]:
+        side = job["write"] if job["write"]["io_bytes"] else job["read"]
+        results[job["jobname"]] = {"mibs": round(side["bw"] / 1024, 1), "iops": round(side["iops"])}
+    return results
+
+
+def chroot_session_commands(count):
+    """The app's session protocol: bash in the target reads commands on one FIFO and answers
+    "@@<id> <status> <start> <end>" on another; a missing or non-zero reply fails the stage."""
+    fifo = "/run/archbench-chroot"
+    cmds = [
+        f"rm -rf {fifo} && mkdir -p {fifo} && mkfifo {fifo}/in {fifo}/out",
+        f"arch-chroot {MNT} /bin/bash --noprofile --norc < {fifo}/in > {fifo}/out 2>&1 &",
+        f"exec 3> {fifo}/in 4< {fifo}/out",
+    ]
+    for i in range(1, count + 1):
+        cmds.append(f"echo 's=$EPOCHREALTIME; {{ true; }} </dev/null; echo \"@@{i} $? $s $EPOCHREALTIME\"' >&3")
+        cmds.append(f"read -r reply <&4 && [[ $reply == '@@{i} 0 '* ]]")
+    cmds += ["echo exit >&3 && wait && exec 3>&- 4<&-", f"rm -rf {fifo}"]
+    return cmds
+
+
+def stage_commands(install_type, profile, jobs, disks, repo, conf, fio_output):
+    """Ordered (stage, [commands]) list; stage names match the app's step names, the commands are
+    simplified versions of what the app queues."""
+    layout = profile["layout"]
+    fs = profile["fs"]
+    esp, root, home = plan_devices(profile, disks)
+    packages = " ".join(INSTALL_TYPES[install_type])
+    stages = []
+
+    cmds = []
+    members = []
+    for disk in disks:
+        cmds.append(f"wipefs -a -q {disk}")
+        cmds.append(f"blkdiscard -f {disk}")
+        cmds.append(f"sgdisk --new=1:0:+512M --typecode=1:ef00 {disk}")
+        if layout == "single":
+            cmds.append(f"sgdisk --new=2:0:+60% --typecode=2:8300 --new=3:0:0 --typecode=3:8300 {disk}")
+        else:
+            cmds.append(f"sgdisk --new=2:0:0 --typecode=2:{'8e00' if layout == 'lvm-stripe' else 'fd00'} {disk}")
+            members.append(partition_path(disk, 2))
+        cmds.append(f"partprobe {disk}")
+    if layout in ("raid0", "raid1"):
+        cmds.append(f"mdadm --create /dev/md/{VG} --run --metadata=1.2 --level={layout[-1]} --raid-devices={len(members)} {' '.join(members)}")
+        cmds.append(f"pvcreate -ff -y /dev/md/{VG} && vgcreate {VG} /dev/md/{VG}")
+        cmds.append(f"lvcreate -y -l 60%VG -n root {VG} && lvcreate -y -l 100%FREE -n home {VG}")
+    elif layout == "lvm-stripe":
+        cmds.append(f"pvcreate -ff -y {' '.join(members)} && vgcreate {VG} {' '.join(members)}")
+        cmds.append(f"lvcreate -y -i {len(members)} -l 60%VG -n root {VG} && lvcreate -y -i {len(members)} -l 100%FREE -n home {VG}")
+    stages.append(("Partitioning", cmds))
+
+    stages.append(("Formatting", [f"mkfs.fat -F32 {esp}", mkfs(fs, root, "root"), mkfs(fs, home, "home")]))
+
+    cmds = [f"mkdir -p {MNT}"]
+    if fs == "btrfs":
+        # Root is subvolume @, as in the app's snapshot layout
+        cmds += [f"mount {root} {MNT}", f"btrfs subvolume create {MNT}/@", f"umount {MNT}", f"mount -o subvol=@ {root} {MNT}"]
+    else:
+        cmds.append(f"mount {root} {MNT}")
+    cmds += [f"mkdir -p {MNT}/boot/efi {MNT}/home", f"mount {esp} {MNT}/boot/efi", f"mount {home} {MNT}/home"]
+    stages.append(("Mounting", cmds))
+    stages.append(("Throughput", fio_commands(fio_output)))
+
+    cache = f"{MNT}/var/cache/pacman/pkg"
+    stages.append(("Download", [
+        f"mkdir -p {cache} {MNT}/var/lib/pacman",
+        f"pacman --config {conf} --dbpath {MNT}/var/lib/pacman -Sy --noconfirm -w --cachedir {cache} {packages}",
+    ]))
+    stages.append(("Install", [f"pacstrap -C {conf} {MNT} {packages}"]))
+    # Entering the target: the same no-op commands, one arch-chroot each vs. one session
+    stages.append(("Chroot per command", [f"arch-chroot {MNT} true"] * CHROOT_BENCH_COMMANDS))
+    stages.append(("Chroot session", chroot_session_commands(CHROOT_BENCH_COMMANDS)))
+    stages.append(("Verify", [
+        f"find {MNT}/usr -xdev -type f -print0 | xargs -0 -P {jobs} -n 512 sha256sum > /dev/null",
+    ]))
+
+    # Configure through Service config share one chroot, like archinstallus_chroot_run
+    session = "; ".join([
+        "sed -i 's/^#en_US.UTF-8 /en_US.UTF-8 /' /etc/locale.gen && locale-gen",
+        "echo LANG=en_US.UTF-8 > /etc/locale.conf",
+        "ln -sf /usr/share/zoneinfo/UTC /etc/localtime",
+        "echo archbench > /etc/hostname",
+        "useradd -m -G wheel -s /bin/bash bench",
+        "systemctl enable NetworkManager.service systemd-timesyncd.service fstrim.timer",
+    ])
+    stages.append(("Configure", [f"genfstab -U {MNT} >> {MNT}/etc/fstab", f"arch-chroot {MNT} bash -ec \"{session}\""]))
+    stages.append(("Bootloader", [f"arch-chroot {MNT} bootctl --esp-path=/boot/efi --no-variables install"]))
+    stages.append(("Cleanup", [
+        f"echo 'COMPRESSION=\"zstd\"' >> {MNT}/etc/mkinitcpio.conf",
+        f"echo 'COMPRESSION_OPTIONS=(-3 -T{jobs})' >> {MNT}/etc/mkinitcpio.conf",
+        f"arch-chroot {MNT} mkinitcpio -P",
+        "sync",
+    ]))
+    return stages
+
+
+def write_pacman_conf(path, repo, jobs):
+    with open(path, "w") as f:
+        f.write(f"[options]\nArchitecture = auto\nParallelDownloads = {jobs}\nSigLevel = Never\n\n")
+        f.write(f"[bench]\nServer = file://{os.path.abspath(repo)}\n")
+
+
+def loop_bytes_written(loops):
+    total = 0
+    for loop in loops:
+        try:
+            with open(f"/sys/block/{os.path.basename(loop)}/stat") as f:
+                total += int(f.read().split()[6]) * 512  # sectors written
+        except OSError:
+            pass
+    return total
+
+
+def run_stage(commands, loops, dry_run):
+    """Run one stage's commands in a single shell; wall time, bytes written, peak RSS."""
+    if dry_run:
+        for cmd in commands:
+            print(f"  {cmd}")
+        return {"wall_s": 0.0, "bytes_written": 0, "peak_rss_kib": 0}
+
+    written = loop_bytes_written(loops)
+    start = time.monotonic()
+    proc = subprocess.Popen(["bash", "-euo", "pipefail", "-c", "\n".join(commands)])
+    # wait4 reports the largest resident set among the stage's processes
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.monotonic() - start
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise RuntimeError(f"stage failed: {commands}")
+    return {
+        "wall_s": round(wall, 3),
+        "bytes_written": loop_bytes_written(loops) - written,
+        "peak_rss_kib": usage.ru_maxrss,
+    }
+
+
+def teardown(loops, images, dry_run):
+    cmds = [f"umount -R {MNT}", f"vgchange -an {VG}", f"mdadm --stop /dev/md/{VG}"]
+    cmds += [f"losetup -d {loop}" for loop in loops]
+    for cmd in cmds:
+        if dry_run:
+            print(f"  {cmd}")
+        else:
+            subprocess.run(cmd, shell=True, stderr=subprocess.DEVNULL)
+    for image in images:
+        if not dry_run and os.path.exists(image):
+            os.unlink(image)
+
+
+def run_one(install_type, profile_name, jobs, args):
+    profile = PROFILES[profile_name]
+    images = [os.path.join(args.workdir, f"disk{i}.img") for i in range(profile["disks"])]
+    loops = []
+    for i, image in enumerate(images):
+        if args.dry_run:
+            loops.append(f"/dev/loop{i}")
+            continue
+        # Sparse, so only the blocks the install writes take space
+        with open(image, "wb") as f:
+            f.truncate(args.size_gib << 30)
+        loops.append(subprocess.check_output(["losetup", "-f", "--show", "-P", "--direct-io=on", image], text=True).strip())
+
+    conf = os.path.join(args.workdir, "pacman.conf")
+    fio_output = os.path.join(args.workdir, "fio.json")
+    write_pacman_conf(conf, args.repo, jobs)
+    result = {"type": install_type, "profile": profile_name, "jobs": jobs, "stages": []}
+    try:
+        for name, commands in stage_commands(install_type, profile, jobs, loops, args.repo, conf, fio_output):
+            if args.dry_run:
+                print(f"[{name}]")
+            stage = run_stage(commands, loops, args.dry_run)
+            stage["name"] = name
+            if name == "Throughput" and not args.dry_run:
+                stage["fio"] = read_fio(fio_output)
+            result["stages"].append(stage)
+    finally:
+        teardown(loops, images, args.dry_run)
+    result["total_s"] = round(sum(s["wall_s"] for s in result["stages"]), 3)
+    return result
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "--short", "HEAD"], text=True, stderr=subprocess.DEVNULL).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def cmd_run(args):
+    if not args.dry_run and os.geteuid() != 0:
+        print("run needs root (loop devices, mkfs, mount); use --dry-run to print the commands", file=sys.stderr)
+        return 1
+    types = args.types.split(",")
+    profiles = args.profiles.split(",")
+    jobs = [int(j) for j in args.jobs.split(",")]
+    for name in types:
+        if name not in INSTALL_TYPES:
+            print(f"unknown install type {name}", file=sys.stderr)
+            return 1
+    for name in profiles:
+        if name not in PROFILES:
+            print(f"unknown profile {name}", file=sys.stderr)
+            return 1
+
+    os.makedirs(args.workdir, exist_ok=True)
+    results = {
+        "version": 1,
+        "revision": git_revision(),
+        "host": platform.node(),
+        "kernel": platform.release(),
+        "size_gib": args.size_gib,
+        "runs": [],
+    }
+    for install_type, profile, job in itertools.product(types, profiles, jobs):
+        print(f"== {install_type} / {profile} / jobs={job}", file=sys.stderr)
+        run = run_one(install_type, profile, job, args)
+        results["runs"].append(run)
+        if not args.dry_run:
+            fio = next(s["fio"] for s in run["stages"] if "fio" in s)
+            print(f"   {run['total_s']:.1f}s, " + ", ".join(
+                f"{name} {fio[name]['mibs']:.0f} MiB/s" for name, *_ in FIO_JOBS), file=sys.stderr)
+
+    if not args.dry_run:
+        with open(args.out, "w") as f:
+            json.dump(results, f, indent=2)
+        print(f"wrote {args.out}", file=sys.stderr)
+    return 0
+
+
+def cmd_compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.candidate) as f:
+        candidate = json.load(f)
+
+    def key(run):
+        return (run["type"], run["profile"], run["jobs"])
+
+    base_runs = {key(r): r for r in baseline["runs"]}
+    regressions = 0
+    print(f"{baseline.get('revision') or '?'} -> {candidate.get('revision') or '?'}, threshold {args.threshold}%")
+    for run in candidate["runs"]:
+        base = base_runs.get(key(run))
+        if not base:
+            print(f"{'/'.join(map(str, key(run)))}: no baseline")
+            continue
+        base_stages = {s["name"]: s for s in base["stages"]}
+        print(f"{'/'.join(map(str, key(run)))}: {base['total_s']:.1f}s -> {run['total_s']:.1f}s")
+        for stage in run["stages"]:
+            old = base_stages.get(stage["name"])
+            if not old:
+                continue
+            delta = stage["wall_s"] - old["wall_s"]
+            pct = 100.0 * delta / old["wall_s"] if old["wall_s"] > 0 else 0.0
+            # Small absolute changes are noise, whatever their percentage
+            regressed = pct > args.threshold and delta > args.min_seconds
+            regressions += regressed
+            print(f"  {stage['name']:14} {old['wall_s']:8.2f}s {stage['wall_s']:8.2f}s {pct:+6.1f}%"
+                  f"  written {stage['bytes_written'] >> 20}M  rss {stage['peak_rss_kib'] >> 10}M"
+                  f"{'  REGRESSION' if regressed else ''}")
+            # Throughput regresses when it drops; the fio stage runs a fixed amount of I/O
+            for job, new in stage.get("fio", {}).items():
+                before = old.get("fio", {}).get(job)
+                if not before or before["mibs"] <= 0:
+                    continue
+                drop = 100.0 * (before["mibs"] - new["mibs"]) / before["mibs"]
+                regressed = drop > args.threshold
+                regressions += regressed
+                print(f"    {job:12} {before['mibs']:8.1f} {new['mibs']:8.1f} MiB/s {-drop:+6.1f}%"
+                      f"{'  REGRESSION' if regressed else ''}")
+    print(f"{regressions} regression(s)")
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Loop-device install benchmark for ArchInstallus")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    run = sub.add_parser("run", help="run the benchmark matrix")
+    run.add_argument("--repo", required=True, help="local repository directory (repo-add database 'bench')")
+    run.add_argument("--types", default="minimal,full", help="install types, comma separated")
+    run.add_argument("--profiles", default="ext4,btrfs", help=f"filesystem profiles: {','.join(PROFILES)}")
+    run.add_argument("--jobs", default="1,4", help="parallelism settings, comma separated")
+    run.add_argument("--size-gib", type=int, default=32, help="size of each sparse disk image")
+    run.add_argument("--workdir", default=os.path.join(tempfile.gettempdir(), "archinstallus-bench"))
+    run.add_argument("--out", default="bench-results.json")
+    run.add_argument("--dry-run", action="store_true", help="print the command stream only")
+
+    compare = sub.add_parser("compare", help="flag regressions between two results files")
+    compare.add_argument("baseline")
+    compare.add_argument("candidate")
+    compare.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown per stage in percent")
+    compare.add_argument("--min-seconds", type=float, default=0.5, help="ignore stage changes smaller than this")
+
+    args = parser.parse_args()
+    return cmd_run(args) if args.command == "run" else cmd_compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""
+ArchInstallus trace aggregator
+
+Reads Chrome trace files exported by the app (apps_data/archinstallus/traces/*.json)
+from one or more runs and prints per-step latency histograms.
+
+Usage: trace_histogram.py [--substeps] [--buckets N] trace.json [trace.json ...]
+"""
+
+import argparse
+import json
+import sys
+from collections import defaultdict
+
+
+def load_spans(paths, include_substeps):
+    durations = defaultdict(list)
+    waits = defaultdict(list)
+    runs = 0
+    for path in paths:
+        try:
+            with open(path) as f:
+                trace = json.load(f)
+        except (OSError, ValueError) as e:
+            print(f"skipping {path}: {e}", file=sys.stderr)
+            continue
+        runs += 1
+        for event in trace.get("traceEvents", []):
+            if event.get("ph") != "X":
+                continue
+            if event.get("cat") != "step" and not include_substeps:
+                continue
+            name = event["name"]
+            durations[name].append(event["dur"] / 1000.0)
+            waits[name].append(event.get("args", {}).get("wait_us", 0) / 1000.0)
+    return runs, durations, waits
+
+
+def percentile(values, pct):
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(pct / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def print_histogram(name, values, waits, buckets):
+    low, high = min(values), max(values)
+    width = (high - low) / buckets if high > low else 1.0
+    counts = [0] * buckets
+    for v in values:
+        counts[min(buckets - 1, int((v - low) / width))] += 1
+
+    wait_share = 100.0 * sum(waits) / sum(values) if sum(values) > 0 else 0.0
+    print(f"{name}  n={len(values)}  p50={percentile(values, 50):.1f}ms  "
+          f"p90={percentile(values, 90):.1f}ms  p99={percentile(values, 99):.1f}ms  "
+          f"wait={wait_share:.0f}%")
+    peak = max(counts)
+    for i, count in enumerate(counts):
+        bar = "#" * (count * 40 // peak if peak else 0)
+        print(f"  {low + i * width:9.1f}ms | {bar} {count}")
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Aggregate ArchInstallus traces into per-step histograms")
+    parser.add_argument("traces", nargs="+", help="trace JSON files")
+    parser.add_argument("--substeps", action="store_true", help="include sub-step spans")
+    parser.add_argument("--buckets", type=int, default=10, help="histogram buckets per step")
+    args = parser.parse_args()
+
+    runs, durations, waits = load_spans(args.traces, args.substeps)
+    if runs == 0:
+        print("no traces loaded", file=sys.stderr)
+        return 1
+
+    print(f"{runs} run(s)\n")
+    # Slowest steps first: that is where optimization pays off
+    for name in sorted(durations, key=lambda n: -sum(durations[n]) / len(durations[n])):
+        print_histogram(name, durations[name], waits[name], args.buckets)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+ArchInstallus build variant report
+
+Reads the App() entries from application.fam, finds each variant's built .fap and prints
+its file size, section sizes, relocation count and estimated load time from SD.
+
+Usage: variant_report.py [--build] [--dir DIST_DIR] [--sd-kibs N] [--reloc-us N]
+
+Load time is estimated as file read at --sd-kibs plus --reloc-us per relocation
+(the loader resolves every relocation against the firmware API table). Everything the
+loader reads ends up in RAM, so the load footprint is also heap the install cannot use.
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+from types import SimpleNamespace
+
+APP_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def load_variants(fam_path):
+    apps = []
+
+    def collect(**kwargs):
+        apps.append(kwargs)
+
+    with open(fam_path) as f:
+        exec(f.read(), {"App": collect, "FlipperAppType": SimpleNamespace(EXTERNAL="EXTERNAL")})
+    return apps
+
+
+def find_fap(appid, dirs):
+    for d in dirs:
+        path = os.path.join(d, f"{appid}.fap")
+        if os.path.exists(path):
+            return path
+    return None
+
+
+def tool(name):
+    for candidate in (f"arm-none-eabi-{name}", name):
+        if shutil.which(candidate):
+            return candidate
+    return None
+
+
+def section_sizes(path):
+    size = tool("size")
+    sizes = {"text": 0, "data": 0, "bss": 0}
+    if not size:
+        return sizes
+    out = subprocess.run([size, "-A", path], capture_output=True, text=True, check=True).stdout
+    for line in out.splitlines():
+        m = re.match(r"^(\.\S+)\s+(\d+)", line)
+        if not m:
+            continue
+        name, value = m.group(1), int(m.group(2))
+        if name.startswith((".text", ".rodata")):
+            sizes["text"] += value
+        elif name.startswith(".data"):
+            sizes["data"] += value
+        elif name.startswith(".bss"):
+            sizes["bss"] += value
+    return sizes
+
+
+def relocation_count(path):
+    readelf = tool("readelf")
+    if not readelf:
+        return 0
+    out = subprocess.run([readelf, "-r", "-W", path], capture_output=True, text=True, check=True).stdout
+    return sum(1 for line in out.splitlines() if "R_ARM_" in line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Size and load-time report per ArchInstallus build variant")
+    parser.add_argument("--build", action="store_true", help="run ufbt first (builds every App in application.fam)")
+    parser.add_argument("--dir", action="append", default=[], help="directory holding built .fap files")
+    parser.add_argument("--sd-kibs", type=int, default=500, help="SD read throughput in KiB/s")
+    parser.add_argument("--reloc-us", type=int, default=3, help="loader cost per relocation in microseconds")
+    args = parser.parse_args()
+
+    if args.build:
+        subprocess.run(["ufbt"], cwd=APP_DIR, check=True)
+
+    dirs = args.dir or [os.path.join(APP_DIR, "dist"), os.path.join(APP_DIR, "build")]
+    variants = load_variants(os.path.join(APP_DIR, "application.fam"))
+
+    baseline = None
+    print(f"{'variant':24} {'fap':>8} {'text':>8} {'data':>6} {'bss':>6} {'relocs':>7} {'load':>8}  cdefines")
+    for app in variants:
+        appid = app["appid"]
+        path = find_fap(appid, dirs)
+        cdefines = ",".join(app.get("cdefines", [])) or "-"
+        if not path:
+            print(f"{appid:24} {'not built':>8}  {cdefines}")
+            continue
+
+        fap_bytes = os.path.getsize(path)
+        sizes = section_sizes(path)
+        relocs = relocation_count(path)
+        load_ms = fap_bytes * 1000 // (args.sd_kibs * 1024) + relocs * args.reloc_us // 1000
+        print(f"{appid:24} {fap_bytes:8} {sizes['text']:8} {sizes['data']:6} {sizes['bss']:6} "
+              f"{relocs:7} {load_ms:6}ms  {cdefines}")
+
+        # First entry is the full build; the others are reported against it
+        if baseline is None:
+            baseline = (fap_bytes, load_ms)
+        else:
+            saved = baseline[0] - fap_bytes
+            print(f"{'':24} {-saved:+8} bytes, {load_ms - baseline[1]:+d}ms vs {variants[0]['appid']}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())